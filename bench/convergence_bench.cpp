@@ -0,0 +1,120 @@
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Dataset.hpp"
+#include "MLP.hpp"
+
+// Wall-clock time to a target reconstruction loss for each optimizer and
+// schedule, all starting from the same initial weights on the same samples.
+// The images are decoded into memory first, so only training is timed. With
+// a validation fraction the held-out loss is the one that must reach the
+// target; otherwise the training loss is.
+// Usage: ConvergenceBench [--data PATH] [--patch N] [--batch N] [--threads N]
+//                         [--target L] [--max-epochs N] [--validation-fraction F]
+
+namespace {
+
+struct Config {
+  const char* name;
+  Optimizer optimizer;
+  float learning_rate;
+  Schedule schedule;
+  int warmup_percent; // Of max_epochs
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string data_path = "image.bmp";
+    DatasetOptions dataset_options;
+    TrainOptions base;
+    base.report_epochs = 0;
+    base.target_loss = 0.005f;
+    int max_epochs = 2000;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--data" && i + 1 < argc) {
+            data_path = argv[++i];
+        } else if (arg == "--patch" && i + 1 < argc) {
+            dataset_options.patch = std::stoi(argv[++i]);
+        } else if (arg == "--batch" && i + 1 < argc) {
+            base.batch_size = std::stoi(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            base.threads = std::stoi(argv[++i]);
+        } else if (arg == "--target" && i + 1 < argc) {
+            base.target_loss = std::stof(argv[++i]); // Mean squared error per pixel
+        } else if (arg == "--max-epochs" && i + 1 < argc) {
+            max_epochs = std::stoi(argv[++i]);
+        } else if (arg == "--validation-fraction" && i + 1 < argc) {
+            base.validation_fraction = std::stof(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--data PATH] [--patch N] [--batch N] [--threads N] [--target L]"
+                      << " [--max-epochs N] [--validation-fraction F]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Decode every sample once, in file order
+    std::vector<std::vector<float>> samples;
+    {
+        dataset_options.shuffle_buffer = 0;
+        ImageDataset dataset(data_path, dataset_options);
+        dataset.start_epoch(0, 256);
+        Batch batch;
+        while (dataset.next(batch)) {
+            for (int b = 0; b < batch.count; ++b) {
+                samples.emplace_back(batch.inputs[b], batch.inputs[b] + dataset.input_size());
+            }
+        }
+    }
+    const int sample_size = static_cast<int>(samples.front().size());
+
+    // Every configuration starts from these weights
+    const std::vector<int> layers = {sample_size, 128, 64, 32, 64, 128, sample_size};
+    const std::string initial = (std::filesystem::temp_directory_path() / "convergence_bench_init.dat").string();
+    MLP(layers, 0.01f).save_model(initial);
+
+    const Config configs[] = {
+        {"sgd", Optimizer::SGD, 0.01f, Schedule::Constant, 0}, // What train.cpp has always done
+        {"momentum", Optimizer::Momentum, 0.01f, Schedule::Constant, 0},
+        {"adam", Optimizer::Adam, 0.001f, Schedule::Constant, 0},
+        {"adam+warmup+cosine", Optimizer::Adam, 0.003f, Schedule::Cosine, 5},
+    };
+
+    std::cout << samples.size() << " samples of " << sample_size << ", batch " << base.batch_size << ", target "
+              << base.target_loss << (base.validation_fraction > 0.0f ? " (validation)" : " (training)")
+              << " within " << max_epochs << " epochs" << std::endl;
+    std::cout << "config               epochs  seconds    loss       reached  speedup" << std::endl;
+    double baseline = 0.0;
+    for (const Config& config : configs) {
+        MLP mlp = MLP::from_file(initial);
+        TrainOptions options = base;
+        options.optimizer.kind = config.optimizer;
+        options.learning_rate = config.learning_rate;
+        options.schedule.kind = config.schedule;
+        options.schedule.warmup_epochs = max_epochs * config.warmup_percent / 100;
+
+        EpochStats last;
+        mlp.set_stats_callback([&](const EpochStats& epoch) { last = epoch; });
+        const auto start = std::chrono::steady_clock::now();
+        mlp.train(samples, samples, max_epochs, options);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        const float loss = last.validation_loss >= 0.0f ? last.validation_loss : last.loss;
+        const bool reached = loss <= base.target_loss;
+        if (baseline == 0.0) {
+            baseline = seconds;
+        }
+        std::cout << std::left << std::setw(21) << config.name << std::setw(8) << last.epoch << std::fixed
+                  << std::setprecision(2) << std::setw(11) << seconds << std::setprecision(5) << std::setw(11) << loss
+                  << std::setw(9) << (reached ? "yes" : "no") << std::setprecision(2) << baseline / seconds << "x"
+                  << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+    }
+    std::filesystem::remove(initial);
+    return 0;
+}
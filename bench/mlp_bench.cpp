@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Kernels.hpp"
+#include "MLP.hpp"
+
+// Trains and runs {width, hidden, width} networks over a matrix of widths and
+// batch sizes and writes one JSON document: per-layer forward, backward and
+// update time, GFLOP/s and estimated bandwidth, plus overall samples/sec for
+// training and inference. Timings come from the library's MLP_STATS counters.
+// Usage: MLPBench [--widths 256,1024,4096] [--batches 1,16,64,256] [--hidden N]
+//                 [--samples N] [--epochs N] [--threads N] [--output FILE]
+
+namespace {
+
+std::vector<int> parse_list(const std::string& text) {
+    std::vector<int> values;
+    std::stringstream stream(text);
+    for (std::string item; std::getline(stream, item, ',');) {
+        values.push_back(std::stoi(item));
+    }
+    return values;
+}
+
+// Work done by one layer over an epoch of `samples` rows in steps of `batch`
+struct LayerCost {
+    double forward_flops, backward_flops, update_flops;
+    double forward_bytes, backward_bytes, update_bytes;
+};
+
+LayerCost layer_cost(const std::vector<int>& topology, size_t layer, double samples, double steps) {
+    const double in = topology[layer];
+    const double out = topology[layer + 1];
+    const double weight_bytes = (in * out + out) * sizeof(float);
+    LayerCost cost;
+    // Weights stream once per step; activations once per sample
+    cost.forward_flops = 2 * samples * in * out;
+    cost.forward_bytes = steps * weight_bytes + samples * (in + out) * sizeof(float);
+    if (layer + 2 < topology.size()) { // D[i] = D[i + 1] * W[i + 1]
+        const double next = topology[layer + 2];
+        cost.backward_flops = 2 * samples * out * next;
+        cost.backward_bytes = steps * (next * out) * sizeof(float) + samples * (next + 2 * out) * sizeof(float);
+    } else { // Output delta is elementwise
+        cost.backward_flops = 3 * samples * out;
+        cost.backward_bytes = samples * 3 * out * sizeof(float);
+    }
+    cost.update_flops = 2 * samples * in * out + samples * out;
+    cost.update_bytes = steps * 2 * weight_bytes + samples * (in + out) * sizeof(float); // Read and write
+    return cost;
+}
+
+double rate(double amount, double seconds) {
+    return seconds > 0.0 ? amount / seconds : 0.0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<int> widths = {256, 1024, 4096};
+    std::vector<int> batches = {1, 16, 64, 256};
+    int hidden = 128;
+    int samples = 512;
+    int epochs = 2;
+    int threads = 1;
+    std::string output_filename;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 1;
+        }
+        if (arg == "--widths") {
+            widths = parse_list(argv[++i]);
+        } else if (arg == "--batches") {
+            batches = parse_list(argv[++i]);
+        } else if (arg == "--hidden") {
+            hidden = std::stoi(argv[++i]);
+        } else if (arg == "--samples") {
+            samples = std::stoi(argv[++i]);
+        } else if (arg == "--epochs") {
+            epochs = std::stoi(argv[++i]);
+        } else if (arg == "--threads") {
+            threads = std::stoi(argv[++i]);
+        } else if (arg == "--output") {
+            output_filename = argv[++i];
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::ostringstream json;
+    json << "{\n  \"isa\": \"" << kernels::isa_name(kernels::active_isa()) << "\",\n"
+         << "  \"threads\": " << threads << ",\n  \"samples\": " << samples << ",\n  \"epochs\": " << epochs
+         << ",\n  \"results\": [";
+
+    bool first_result = true;
+    for (int width : widths) {
+        std::vector<std::vector<float>> data(samples, std::vector<float>(width));
+        for (auto& sample : data) {
+            for (float& value : sample) {
+                value = static_cast<float>(rand()) / RAND_MAX;
+            }
+        }
+        const std::vector<int> topology = {width, hidden, width};
+
+        for (int batch : batches) {
+            std::cerr << "width " << width << ", batch " << batch << std::endl;
+            MLP mlp(topology, 0.01f);
+            TrainOptions options;
+            options.batch_size = batch;
+            options.threads = threads;
+
+            // Sum the stats of the measured epochs; the first call warms up buffers and the pool
+            std::streambuf* console = std::cout.rdbuf(nullptr); // Silence the epoch print
+            mlp.train(data, data, 1, options);
+            EpochStats total;
+            total.layers.resize(topology.size() - 1);
+            mlp.set_stats_callback([&](const EpochStats& epoch) {
+                total.samples += epoch.samples;
+                total.seconds += epoch.seconds;
+                total.all_reduce_seconds += epoch.all_reduce_seconds;
+                total.allocations += epoch.allocations;
+                for (size_t i = 0; i < epoch.layers.size(); ++i) {
+                    total.layers[i].forward += epoch.layers[i].forward;
+                    total.layers[i].backward += epoch.layers[i].backward;
+                    total.layers[i].update += epoch.layers[i].update;
+                }
+                total.loss = epoch.loss;
+            });
+            mlp.train(data, data, epochs, options);
+            std::cout.rdbuf(console);
+            std::cout.clear();
+
+            // Inference over the same samples in batches of the same size
+            Workspace workspace(topology, batch);
+            std::vector<float> inputs(static_cast<size_t>(samples) * width);
+            std::vector<float> outputs(inputs.size());
+            for (int s = 0; s < samples; ++s) {
+                std::copy(data[s].begin(), data[s].end(), inputs.begin() + static_cast<size_t>(s) * width);
+            }
+            double predict_seconds = 1e30;
+            for (int run = 0; run < 3; ++run) {
+                auto start = std::chrono::steady_clock::now();
+                for (int s = 0; s < samples; s += batch) {
+                    mlp.predict_batch(inputs.data() + static_cast<size_t>(s) * width, width,
+                                      outputs.data() + static_cast<size_t>(s) * width, width,
+                                      std::min(batch, samples - s), workspace);
+                }
+                predict_seconds = std::min(predict_seconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            }
+
+            const double trained = static_cast<double>(total.samples);
+            const double steps = epochs * std::ceil(static_cast<double>(samples) / batch);
+            double total_flops = 0.0;
+            json << (first_result ? "\n" : ",\n") << "    {\"topology\": [" << width << ", " << hidden << ", " << width
+                 << "], \"batch\": " << batch
+                 << ", \"train_samples_per_second\": " << rate(trained, total.seconds)
+                 << ", \"predict_samples_per_second\": " << rate(samples, predict_seconds)
+                 << ", \"epoch_seconds\": " << total.seconds / epochs
+                 << ", \"all_reduce_seconds\": " << total.all_reduce_seconds
+                 << ", \"allocations\": " << total.allocations
+                 << ", \"loss\": " << total.loss << ",\n     \"layers\": [";
+            for (size_t i = 0; i < total.layers.size(); ++i) {
+                const LayerTimes& times = total.layers[i];
+                const LayerCost cost = layer_cost(topology, i, trained, steps);
+                total_flops += cost.forward_flops + cost.backward_flops + cost.update_flops;
+                json << (i == 0 ? "\n" : ",\n") << "       {\"inputs\": " << topology[i] << ", \"outputs\": " << topology[i + 1]
+                     << ", \"forward_ms\": " << times.forward * 1e3
+                     << ", \"backward_ms\": " << times.backward * 1e3
+                     << ", \"update_ms\": " << times.update * 1e3
+                     << ", \"forward_gflops\": " << rate(cost.forward_flops, times.forward) * 1e-9
+                     << ", \"backward_gflops\": " << rate(cost.backward_flops, times.backward) * 1e-9
+                     << ", \"update_gflops\": " << rate(cost.update_flops, times.update) * 1e-9
+                     << ", \"forward_gbps\": " << rate(cost.forward_bytes, times.forward) * 1e-9
+                     << ", \"backward_gbps\": " << rate(cost.backward_bytes, times.backward) * 1e-9
+                     << ", \"update_gbps\": " << rate(cost.update_bytes, times.update) * 1e-9 << "}";
+            }
+            json << "],\n     \"train_gflops\": " << rate(total_flops, total.seconds) * 1e-9 << "}";
+            first_result = false;
+        }
+    }
+    json << "\n  ]\n}\n";
+
+    if (output_filename.empty()) {
+        std::cout << json.str();
+    } else {
+        std::ofstream(output_filename) << json.str();
+        std::cerr << "Wrote " << output_filename << std::endl;
+    }
+    return 0;
+}
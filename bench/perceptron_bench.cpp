@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Kernels.hpp"
+#include "Perceptron.hpp"
+
+// Throughput of the perceptron engine on synthetic, linearly separable data:
+// binary training (plain and averaged), scalar and batched prediction, and
+// one-vs-rest training over 1..N threads, all in samples/sec.
+// Usage: PerceptronBench [samples] [features] [classes] [max_threads]
+
+namespace {
+
+constexpr int kEpochs = 3;
+
+template <typename Work>
+double seconds(Work work) {
+    auto start = std::chrono::steady_clock::now();
+    work();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double accuracy(std::span<const int> predicted, std::span<const int> labels) {
+    size_t correct = 0;
+    for (size_t i = 0; i < labels.size(); ++i) {
+        correct += predicted[i] == labels[i];
+    }
+    return 100.0 * correct / labels.size();
+}
+
+void report(const std::string& name, double samples_per_second, double percent) {
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(0)
+              << std::setw(14) << samples_per_second << std::setprecision(1) << std::setw(10) << percent << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const int samples = argc > 1 ? std::stoi(argv[1]) : 200000;
+    const int features = argc > 2 ? std::stoi(argv[2]) : 64;
+    const int classes = argc > 3 ? std::stoi(argv[3]) : 10;
+    const int max_threads = argc > 4 ? std::stoi(argv[4]) : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    // Features in [-1, 1]; labels from hidden hyperplanes, so both problems are separable
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    SampleMatrix data(samples, features);
+    std::vector<std::vector<float>> planes(classes, std::vector<float>(features));
+    for (auto& plane : planes) {
+        for (float& value : plane) {
+            value = uniform(rng);
+        }
+    }
+    std::vector<int> binary_labels(samples);
+    std::vector<int> class_labels(samples);
+    for (int i = 0; i < samples; ++i) {
+        float* row = data.row(i);
+        for (int f = 0; f < features; ++f) {
+            row[f] = uniform(rng);
+        }
+        float best = -1e30f;
+        for (int c = 0; c < classes; ++c) {
+            const float score = kernels::dot(row, planes[c].data(), features);
+            if (c == 0) {
+                binary_labels[i] = score >= 0.0f ? 1 : 0;
+            }
+            if (score > best) {
+                best = score;
+                class_labels[i] = c;
+            }
+        }
+    }
+    std::vector<int> predicted(samples);
+
+    std::cout << "Kernels: " << kernels::isa_name(kernels::active_isa()) << ", " << samples << " samples of "
+              << features << " features, " << kEpochs << " epochs" << std::endl;
+    std::cout << "stage                        samples/sec  accuracy" << std::endl;
+
+    for (bool averaged : {false, true}) {
+        Perceptron perceptron(features, 0.01f);
+        PerceptronOptions options;
+        options.averaged = averaged;
+        const double train = seconds([&] { perceptron.train(data, binary_labels, kEpochs, options); });
+        perceptron.predict_many(data, predicted);
+        report(averaged ? "binary train (averaged)" : "binary train", samples * kEpochs / train, accuracy(predicted, binary_labels));
+    }
+
+    Perceptron perceptron(features, 0.01f);
+    perceptron.train(data, binary_labels, kEpochs);
+    const double single = seconds([&] {
+        for (int i = 0; i < samples; ++i) {
+            predicted[i] = perceptron.classify(std::span<const float>(data.row(i), features));
+        }
+    });
+    report("binary classify", samples / single, accuracy(predicted, binary_labels));
+    const double batched = seconds([&] { perceptron.predict_many(data, predicted); });
+    report("binary predict_many", samples / batched, accuracy(predicted, binary_labels));
+
+    std::vector<int> thread_counts;
+    for (int threads = 1; threads < max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+    for (int threads : thread_counts) {
+        OneVsRest classifier(features, classes, 0.01f);
+        PerceptronOptions options;
+        options.averaged = true;
+        options.threads = threads;
+        const double train = seconds([&] { classifier.train(data, class_labels, kEpochs, options); });
+        classifier.predict_many(data, predicted);
+        report(std::to_string(classes) + "-class train, " + std::to_string(threads) + " thr", samples * kEpochs / train,
+               accuracy(predicted, class_labels));
+        if (threads == max_threads) {
+            const double single_class = seconds([&] {
+                for (int i = 0; i < samples; ++i) {
+                    predicted[i] = classifier.classify(std::span<const float>(data.row(i), features));
+                }
+            });
+            report(std::to_string(classes) + "-class classify", samples / single_class, accuracy(predicted, class_labels));
+            const double batched_class = seconds([&] { classifier.predict_many(data, predicted); });
+            report(std::to_string(classes) + "-class predict_many", samples / batched_class, accuracy(predicted, class_labels));
+        }
+    }
+    return 0;
+}
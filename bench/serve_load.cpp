@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "InferenceServer.hpp"
+
+// Load generator for ServeModel: each client thread keeps one request in
+// flight on its own connection for the given time, then the client-side
+// throughput and latency percentiles are printed.
+// Usage: ServeLoadBench [--socket PATH] [--clients N] [--seconds S] [--u8]
+
+int main(int argc, char* argv[]) {
+    std::string socket_path = ServerOptions().socket_path;
+    int clients = 8;
+    double seconds = 5.0;
+    bool pixels = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (arg == "--clients" && i + 1 < argc) {
+            clients = std::stoi(argv[++i]);
+        } else if (arg == "--seconds" && i + 1 < argc) {
+            seconds = std::stod(argv[++i]);
+        } else if (arg == "--u8") {
+            pixels = true; // Send 8-bit images instead of floats
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--socket PATH] [--clients N] [--seconds S] [--u8]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Connect everyone first, so the timed window only measures requests
+    std::vector<std::unique_ptr<InferenceClient>> connections;
+    for (int c = 0; c < clients; ++c) {
+        connections.push_back(std::make_unique<InferenceClient>(socket_path));
+    }
+    const int inputs = connections.front()->input_size();
+    const int outputs = connections.front()->output_size();
+    std::cout << clients << " clients, " << (pixels ? "u8" : "f32") << " samples of " << inputs
+              << ", server batches up to " << connections.front()->max_batch() << std::endl;
+
+    std::vector<std::vector<float>> latencies(clients);
+    std::atomic<bool> failed{false};
+    const auto start = std::chrono::steady_clock::now();
+    const auto end = start + std::chrono::duration<double>(seconds);
+    std::vector<std::thread> threads;
+    for (int c = 0; c < clients; ++c) {
+        threads.emplace_back([&, c] {
+            std::mt19937 rng(c);
+            std::vector<float> input(inputs), output(outputs);
+            std::vector<std::uint8_t> input_pixels(inputs), output_pixels(outputs);
+            for (int i = 0; i < inputs; ++i) {
+                input_pixels[i] = static_cast<std::uint8_t>(rng());
+                input[i] = input_pixels[i] / 255.0f;
+            }
+            try {
+                for (auto now = std::chrono::steady_clock::now(); now < end;) {
+                    if (pixels) {
+                        connections[c]->predict(input_pixels, output_pixels);
+                    } else {
+                        connections[c]->predict(input, output);
+                    }
+                    const auto finished = std::chrono::steady_clock::now();
+                    latencies[c].push_back(std::chrono::duration<float, std::micro>(finished - now).count());
+                    now = finished;
+                }
+            } catch (const std::exception& error) {
+                std::cerr << "Client " << c << ": " << error.what() << std::endl;
+                failed = true;
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    // Requests in flight at the deadline finish after it, so throughput is
+    // over the measured window rather than the requested one
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<float> all;
+    for (const std::vector<float>& client : latencies) {
+        all.insert(all.end(), client.begin(), client.end());
+    }
+    const std::size_t requests = all.size();
+    std::cout << std::fixed << std::setprecision(0) << requests << " requests, " << requests / elapsed << " requests/s"
+              << ", latency p50 " << latency_percentile(all, 0.50) << " us, p99 " << latency_percentile(all, 0.99)
+              << " us, p99.9 " << latency_percentile(all, 0.999) << " us" << std::endl;
+    return failed ? 1 : 0;
+}
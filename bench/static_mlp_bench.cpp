@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Kernels.hpp"
+#include "MLP.hpp"
+#include "ModelTools.hpp"
+#include "StaticMLP.hpp"
+
+// Single-sample inference latency of StaticMLP against MLP::predict on the
+// same weights, for a few small topologies, with the achieved GFLOP/s and the
+// largest output difference between the two.
+// Usage: StaticMLPBench [samples] [runs]
+
+namespace {
+
+template <int... Sizes>
+void compare(int samples, int runs) {
+    const std::vector<int> topology = {Sizes...};
+    const int inputs = topology.front();
+    const int outputs = topology.back();
+    double flops = 0.0;
+    for (size_t i = 1; i < topology.size(); ++i) {
+        flops += 2.0 * topology[i - 1] * topology[i];
+    }
+
+    MLP mlp(topology, 0.01f);
+    auto fixed = std::make_unique<StaticMLP<Sizes...>>(mlp);
+    std::vector<float> data(static_cast<size_t>(samples) * inputs);
+    for (float& value : data) {
+        value = static_cast<float>(rand()) / RAND_MAX;
+    }
+    std::vector<float> dynamic_out(static_cast<size_t>(samples) * outputs);
+    std::vector<float> static_out(dynamic_out.size());
+
+    const double dynamic_ns = 1e9 * time_per_sample(samples, 1, [&](int s, int) {
+        mlp.predict(std::span<const float>(data.data() + s * inputs, inputs),
+                    std::span<float>(dynamic_out.data() + s * outputs, outputs));
+    }, runs);
+    const double static_ns = 1e9 * time_per_sample(samples, 1, [&](int s, int) {
+        fixed->predict(data.data() + s * inputs, static_out.data() + s * outputs);
+    }, runs);
+    float difference = 0.0f;
+    for (size_t i = 0; i < static_out.size(); ++i) {
+        difference = std::max(difference, std::fabs(static_out[i] - dynamic_out[i]));
+    }
+
+    std::ostringstream name;
+    for (size_t i = 0; i < topology.size(); ++i) {
+        name << (i == 0 ? "" : "-") << topology[i];
+    }
+    std::cout << std::left << std::setw(24) << name.str() << std::fixed << std::setprecision(1)
+              << std::setw(12) << dynamic_ns << std::setw(12) << static_ns
+              << std::setw(9) << dynamic_ns / static_ns
+              << std::setw(10) << flops / dynamic_ns << std::setw(10) << flops / static_ns
+              << std::scientific << std::setprecision(1) << difference << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const int samples = argc > 1 ? std::stoi(argv[1]) : 1024;
+    const int runs = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    std::cout << "Kernels: " << kernels::isa_name(kernels::active_isa()) << ", " << samples << " samples, best of " << runs << std::endl;
+    std::cout << "topology                MLP (ns)    static (ns) speedup  MLP GF/s  static GF/s  max diff" << std::endl;
+    compare<16, 32, 16>(samples, runs);
+    compare<64, 32, 64>(samples, runs);
+    compare<256, 64, 256>(samples, runs);
+    compare<784, 128, 10>(samples, runs);
+    compare<64, 128, 64, 32, 64, 128, 64>(samples, runs);
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MLP.hpp"
+
+// Trains the train.cpp autoencoder on synthetic images with 1..N threads and
+// reports samples/sec and speedup for synchronous and Hogwild training.
+// Usage: TrainScalingBench [max_threads] [batch_size] [image_side]
+int main(int argc, char* argv[]) {
+    int max_threads = argc > 1 ? std::stoi(argv[1]) : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int batch_size = argc > 2 ? std::stoi(argv[2]) : 64;
+    int side = argc > 3 ? std::stoi(argv[3]) : 64;
+    const int samples = 256;
+    const int epochs = 2;
+
+    std::vector<std::vector<float>> images(samples, std::vector<float>(side * side));
+    for (auto& image : images) {
+        for (float& pixel : image) {
+            pixel = static_cast<float>(rand()) / RAND_MAX;
+        }
+    }
+
+    std::vector<int> thread_counts;
+    for (int threads = 1; threads < max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    std::vector<int> layers = {side * side, 128, 64, 32, 64, 128, side * side};
+    std::cout << "mode         threads  samples/s  speedup" << std::endl;
+    for (Parallelism parallelism : {Parallelism::Synchronous, Parallelism::Hogwild}) {
+        double baseline = 0.0;
+        for (int threads : thread_counts) {
+            MLP mlp(layers, 0.01f);
+            TrainOptions options;
+            options.batch_size = batch_size;
+            options.threads = threads;
+            options.parallelism = parallelism;
+
+            mlp.train(images, images, 1, options); // Warm up the pool and the packing buffers
+            auto start = std::chrono::steady_clock::now();
+            mlp.train(images, images, epochs, options);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            double rate = samples * epochs / seconds;
+            if (threads == 1) {
+                baseline = rate;
+            }
+            std::cout << std::left << std::setw(13) << (parallelism == Parallelism::Hogwild ? "hogwild" : "synchronous")
+                      << std::setw(9) << threads << std::setw(11) << static_cast<int>(rate)
+                      << std::setprecision(3) << rate / baseline << "x" << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,28 @@
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Dataset.hpp"
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <shard> <image or directory>..." << std::endl;
+        return 1;
+    }
+
+    // Collect the images, expanding directories to the image files ImageDataset would read
+    std::vector<std::string> files;
+    for (int i = 2; i < argc; ++i) {
+        if (!std::filesystem::is_directory(argv[i])) {
+            files.push_back(argv[i]);
+            continue;
+        }
+        std::vector<std::string> entries = list_image_files(argv[i]);
+        files.insert(files.end(), entries.begin(), entries.end());
+    }
+
+    pack_image_shard(files, argv[1]);
+    std::cout << "Packed " << files.size() << " images into " << argv[1] << std::endl;
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Dataset.hpp"
+#include "Kernels.hpp"
+#include "MLP.hpp"
+#include "ModelTools.hpp"
+#include "SparseMLP.hpp"
+
+// Prunes a trained model to a target sparsity, optionally fine-tunes it on
+// the image, and saves it with its sparse layers. Reports the format and
+// density of every layer, then the weight size, inference latency and PSNR
+// of the output against the unpruned network on the same samples.
+// Usage: PruneModel [model] [--sparsity S] [--block RxC] [--finetune EPOCHS]
+//                   [--batch N] [--image PATH] [--output PATH]
+
+int main(int argc, char* argv[]) {
+    std::string model_filename = "mlp_model.dat";
+    std::string image_filename = "image.bmp";
+    std::string output_filename;
+    PruneOptions prune_options;
+    int finetune_epochs = 0;
+    TrainOptions train_options;
+    train_options.batch_size = 16;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--sparsity" && i + 1 < argc) {
+            prune_options.sparsity = std::stof(argv[++i]);
+        } else if (arg == "--block" && i + 1 < argc) {
+            std::string shape = argv[++i]; // RxC, e.g. 4x16
+            const size_t x = shape.find('x');
+            if (x == std::string::npos) {
+                std::cerr << "Block shape must be RxC: " << shape << std::endl;
+                return 1;
+            }
+            prune_options.block_rows = std::stoi(shape.substr(0, x));
+            prune_options.block_cols = std::stoi(shape.substr(x + 1));
+        } else if (arg == "--finetune" && i + 1 < argc) {
+            finetune_epochs = std::stoi(argv[++i]);
+        } else if (arg == "--batch" && i + 1 < argc) {
+            train_options.batch_size = std::stoi(argv[++i]);
+        } else if (arg == "--output" && i + 1 < argc) {
+            output_filename = argv[++i];
+        } else if (arg == "--image" && i + 1 < argc) {
+            image_filename = argv[++i];
+        } else if (arg[0] != '-') {
+            model_filename = arg;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [model] [--sparsity S] [--block RxC] [--finetune EPOCHS]"
+                      << " [--batch N] [--image PATH] [--output PATH]" << std::endl;
+            return 1;
+        }
+    }
+    if (output_filename.empty()) { // mlp_model.dat -> mlp_model.sparse.dat
+        std::filesystem::path path(model_filename);
+        output_filename = (path.parent_path() / (path.stem().string() + ".sparse" + path.extension().string())).string();
+    }
+
+    MLP mlp = MLP::from_file(model_filename);
+    const int inputs = mlp.topology().front();
+    const int outputs = mlp.topology().back();
+    int count = 0;
+    std::vector<float> samples = load_samples(image_filename, inputs, count);
+
+    // Unpruned fp32 reference
+    Workspace workspace(mlp.topology(), kBatch);
+    std::vector<float> reference(static_cast<size_t>(count) * outputs);
+    auto predict_dense = [&](int first, int rows) {
+        mlp.predict_batch(samples.data() + first * inputs, inputs, reference.data() + first * outputs, outputs, rows, workspace);
+    };
+    size_t dense_bytes = 0;
+    for (const LayerView& layer : mlp.layers()) {
+        dense_bytes += LayerView::footprint(layer.inputs, layer.outputs) * sizeof(float);
+    }
+    const double dense_single = time_per_sample(count, 1, predict_dense);
+    const double dense_batched = time_per_sample(count, kBatch, predict_dense);
+
+    mlp.prune(prune_options);
+    if (finetune_epochs > 0) {
+        if (!std::filesystem::exists(image_filename)) {
+            std::cerr << "Fine-tuning needs the training image: " << image_filename << std::endl;
+            return 1;
+        }
+        DatasetOptions options;
+        options.patch = patch_for(image_filename, inputs);
+        ImageDataset dataset(image_filename, options);
+        mlp.train(dataset, finetune_epochs, train_options);
+    }
+
+    // Each layer keeps whichever format runs faster on this machine
+    SparseMLP sparse(mlp, FormatPolicy::Fastest, prune_options.block_rows, prune_options.block_cols);
+    std::vector<float> output(reference.size());
+    auto predict_sparse = [&](int first, int rows) {
+        sparse.predict_batch(samples.data() + first * inputs, inputs, output.data() + first * outputs, outputs, rows);
+    };
+    const double sparse_single = time_per_sample(count, 1, predict_sparse);
+    const double sparse_batched = time_per_sample(count, kBatch, predict_sparse);
+
+    std::cout << "Kernels: " << kernels::isa_name(kernels::active_isa()) << ", " << count << " samples of " << inputs
+              << ", " << prune_options.block_rows << "x" << prune_options.block_cols << " blocks at sparsity "
+              << prune_options.sparsity << std::endl;
+    std::cout << "layer  shape           density  format" << std::endl;
+    for (size_t i = 0; i < sparse.layers().size(); ++i) {
+        const SparseLayer& layer = sparse.layers()[i];
+        const std::string shape = std::to_string(layer.outputs) + "x" + std::to_string(layer.inputs);
+        std::cout << std::left << std::setw(7) << i << std::setw(16) << shape << std::fixed << std::setprecision(3)
+                  << std::setw(9) << layer.density() << (layer.format == LayerFormat::Sparse ? "sparse" : "dense") << std::endl;
+    }
+    print_report_header("model", "unpruned");
+    print_report_row("dense", dense_bytes, dense_single, dense_batched, INFINITY);
+    print_report_row("sparse", sparse.payload_bytes(), sparse_single, sparse_batched, psnr(reference, output));
+
+    sparse.save_model(output_filename);
+    std::cout << "Saved pruned model as " << output_filename << std::endl;
+    return 0;
+}
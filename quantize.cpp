@@ -0,0 +1,88 @@
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Kernels.hpp"
+#include "MLP.hpp"
+#include "ModelTools.hpp"
+#include "QuantizedMLP.hpp"
+
+// Converts a trained model to int8, bf16 or f16 weights and reports, for every
+// precision, the weight size, the inference latency and the PSNR of the output
+// against the fp32 network on the same samples.
+// Usage: QuantizeModel [model] [--dtype int8|bf16|f16] [--output PATH] [--image PATH]
+
+int main(int argc, char* argv[]) {
+    std::string model_filename = "mlp_model.dat";
+    std::string image_filename = "image.bmp";
+    std::string output_filename;
+    DType dtype = DType::I8;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--dtype" && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "int8") {
+                dtype = DType::I8;
+            } else if (name == "bf16") {
+                dtype = DType::BF16;
+            } else if (name == "f16") {
+                dtype = DType::F16;
+            } else {
+                std::cerr << "Unknown dtype: " << name << std::endl;
+                return 1;
+            }
+        } else if (arg == "--output" && i + 1 < argc) {
+            output_filename = argv[++i];
+        } else if (arg == "--image" && i + 1 < argc) {
+            image_filename = argv[++i];
+        } else if (arg[0] != '-') {
+            model_filename = arg;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [model] [--dtype int8|bf16|f16] [--output PATH] [--image PATH]" << std::endl;
+            return 1;
+        }
+    }
+    if (output_filename.empty()) { // mlp_model.dat -> mlp_model.int8.dat
+        std::filesystem::path path(model_filename);
+        output_filename = (path.parent_path() / (path.stem().string() + "." + dtype_name(dtype) + path.extension().string())).string();
+    }
+
+    MLP mlp = MLP::open_mapped(model_filename);
+    const int inputs = mlp.topology().front();
+    const int outputs = mlp.topology().back();
+    int count = 0;
+    std::vector<float> samples = load_samples(image_filename, inputs, count);
+
+    // fp32 reference
+    Workspace workspace(mlp.topology(), kBatch);
+    std::vector<float> reference(static_cast<size_t>(count) * outputs);
+    auto predict_f32 = [&](int first, int rows) {
+        mlp.predict_batch(samples.data() + first * inputs, inputs, reference.data() + first * outputs, outputs, rows, workspace);
+    };
+    size_t f32_bytes = 0;
+    for (const LayerView& layer : mlp.layers()) {
+        f32_bytes += LayerView::footprint(layer.inputs, layer.outputs) * sizeof(float);
+    }
+
+    std::cout << "Kernels: " << kernels::isa_name(kernels::active_isa()) << ", " << count << " samples of " << inputs << std::endl;
+    print_report_header("dtype", "f32");
+    print_report_row("f32", f32_bytes, time_per_sample(count, 1, predict_f32), time_per_sample(count, kBatch, predict_f32), INFINITY);
+
+    for (DType candidate : {DType::I8, DType::BF16, DType::F16}) {
+        QuantizedMLP quantized(mlp, candidate);
+        std::vector<float> output(reference.size());
+        auto predict = [&](int first, int rows) {
+            quantized.predict_batch(samples.data() + first * inputs, inputs, output.data() + first * outputs, outputs, rows);
+        };
+        const double single = time_per_sample(count, 1, predict);
+        const double batched = time_per_sample(count, kBatch, predict);
+        print_report_row(dtype_name(candidate), quantized.payload_bytes(), single, batched, psnr(reference, output));
+        if (candidate == dtype) {
+            quantized.save_model(output_filename);
+        }
+    }
+    std::cout << "Saved " << dtype_name(dtype) << " model as " << output_filename << std::endl;
+    return 0;
+}
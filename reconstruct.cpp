@@ -1,19 +1,16 @@
+#include <fstream>
 #include <iostream>
 #include <vector>
 #include <string>
 
-
-#define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
-
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wmissing-field-initializers"
-#pragma clang diagnostic ignored "-Wdeprecated-declarations"
-#define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image_write.h>
-#pragma clang diagnostic pop
 
+#include "InferenceServer.hpp"
 #include "MLP.hpp"
+#include "QuantizedMLP.hpp"
+#include "SparseMLP.hpp"
+#include "Tiling.hpp"
 
 // Function to load image from a file using STB Image
 std::vector<float> load_image(const std::string& filename, int& width, int& height) {
@@ -46,25 +43,90 @@ void save_image(const std::string& filename, const std::vector<float>& image, in
     stbi_write_bmp(filename.c_str(), width, height, 1, output_image.data()); // Save as grayscale BMP
 }
 
-int main() {
+// Whether the file starts with the model format header; files written before it have none
+bool has_model_header(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    unsigned char magic[sizeof(kModelMagic)] = {};
+    file.read(reinterpret_cast<char*>(magic), sizeof(magic));
+    return has_model_magic(magic, static_cast<size_t>(file.gcount()));
+}
+
+int main(int argc, char* argv[]) {
+    // Optional flags for models trained on patches (TrainModel --patch)
+    TileOptions tile_options;
+    std::string model_filename = "mlp_model.dat";
+    std::string server_path;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--overlap" && i + 1 < argc) {
+            tile_options.overlap = std::stoi(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            tile_options.threads = std::stoi(argv[++i]);
+        } else if (arg == "--batch" && i + 1 < argc) {
+            tile_options.batch_size = std::stoi(argv[++i]);
+        } else if (arg == "--model" && i + 1 < argc) {
+            model_filename = argv[++i]; // e.g. a QuantizeModel or PruneModel output
+        } else if (arg == "--server" && i + 1 < argc) {
+            server_path = argv[++i]; // Socket of a running ServeModel
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--overlap N] [--threads N] [--batch N] [--model PATH]"
+                      << " [--server PATH]" << std::endl;
+            return 1;
+        }
+    }
+
     // Load the broken image
     std::string broken_image_filename = "broken.bmp";
     int width, height;
     std::vector<float> inputs = load_image(broken_image_filename, width, height);
 
-    // Define the MLP architecture based on image size
-    std::vector<int> layers = {width * height, 128, 64, 32, 64, 128, width * height}; // Example architecture
-    float learning_rate = 0.01;
-
-    // Create MLP instance
-    MLP mlp(layers, learning_rate);
-
-    // Load the trained model
-    std::string model_filename = "mlp_model.dat";
-    mlp.load_model(model_filename);
-
-    // Reconstruct the image using the MLP
-    std::vector<float> reconstructed_image = mlp.predict(inputs);
+    // Map the trained model; its file describes the architecture and precision
+    std::vector<float> reconstructed_image(inputs.size());
+    if (!server_path.empty()) {
+        // The server holds the model; whole-image models only
+        InferenceClient client(server_path);
+        if (client.input_size() != width * height) {
+            std::cerr << "Error: the served model must cover the whole image" << std::endl;
+            return 1;
+        }
+        client.predict(inputs, reconstructed_image);
+    } else if (!has_model_header(model_filename)) {
+        // Headerless model from an older build: the image size fixes the train.cpp
+        // architecture, and load_model checks the file size against it
+        std::vector<int> layers = {width * height, 128, 64, 32, 64, 128, width * height};
+        MLP mlp(layers, 0.01f);
+        mlp.load_model(model_filename);
+        mlp.predict(inputs, reconstructed_image);
+    } else if (const ModelHeader header = read_model_header(model_filename); header.version == kSparseModelVersion) {
+        // Pruned model from PruneModel or MLP::save_model, whole-image models only
+        SparseMLP sparse = SparseMLP::open_mapped(model_filename);
+        if (sparse.topology().front() != width * height) {
+            std::cerr << "Error: sparse models must cover the whole image" << std::endl;
+            return 1;
+        }
+        sparse.predict(inputs, reconstructed_image);
+    } else if (static_cast<DType>(header.dtype) != DType::F32) {
+        // Reduced-precision weights from QuantizeModel, whole-image models only
+        QuantizedMLP quantized = QuantizedMLP::open_mapped(model_filename);
+        if (quantized.topology().front() != width * height) {
+            std::cerr << "Error: quantized models must cover the whole image" << std::endl;
+            return 1;
+        }
+        quantized.predict(inputs, reconstructed_image);
+    } else {
+        MLP mlp = MLP::open_mapped(model_filename);
+
+        // Reconstruct the image using the MLP: in one pass when the model covers the
+        // whole image, otherwise patch by patch
+        if (mlp.topology().front() == width * height) {
+            mlp.predict(inputs, reconstructed_image);
+        } else {
+            TiledReconstructor reconstructor(mlp, tile_options);
+            TileStats stats = reconstructor.reconstruct(inputs, width, height, reconstructed_image);
+            std::cout << "Reconstructed " << stats.patches << " patches of " << reconstructor.patch_size() << "x"
+                      << reconstructor.patch_size() << " at " << stats.megapixels_per_second << " MP/s" << std::endl;
+        }
+    }
 
     // Save the reconstructed image
     std::string reconstructed_image_filename = "reconstructed.bmp";
@@ -0,0 +1,82 @@
+#include <csignal>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "InferenceServer.hpp"
+#include "MLP.hpp"
+
+// Loads a model once and serves reconstructions over a Unix domain socket,
+// batching concurrent requests, until SIGINT or SIGTERM. Prints request
+// rate, batch size and p50/p99 latency every report interval and at exit.
+// Usage: ServeModel [model] [--socket PATH] [--batch N] [--delay-us N]
+//                   [--workers N] [--report-seconds S]
+
+namespace {
+
+void report(const ServerStats& stats) {
+    std::cout << std::fixed << std::setprecision(1) << stats.requests << " requests in " << stats.seconds << " s ("
+              << stats.requests_per_second << "/s), mean batch " << std::setprecision(2) << stats.mean_batch
+              << ", latency p50 " << std::setprecision(0) << stats.p50_us << " us, p99 " << stats.p99_us << " us";
+    if (stats.rejected > 0) {
+        std::cout << ", " << stats.rejected << " rejected";
+    }
+    std::cout << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string model_filename = "mlp_model.dat";
+    ServerOptions options;
+    int report_seconds = 10;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            options.socket_path = argv[++i];
+        } else if (arg == "--batch" && i + 1 < argc) {
+            options.max_batch = std::stoi(argv[++i]);
+        } else if (arg == "--delay-us" && i + 1 < argc) {
+            options.max_delay = std::chrono::microseconds(std::stoi(argv[++i]));
+        } else if (arg == "--workers" && i + 1 < argc) {
+            options.workers = std::stoi(argv[++i]); // 0 uses every hardware thread
+        } else if (arg == "--report-seconds" && i + 1 < argc) {
+            report_seconds = std::stoi(argv[++i]); // 0 reports at exit only
+        } else if (arg[0] != '-') {
+            model_filename = arg;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [model] [--socket PATH] [--batch N] [--delay-us N]"
+                      << " [--workers N] [--report-seconds S]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Block the stop signals before any thread starts, so only sigtimedwait sees them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    MLP mlp = MLP::open_mapped(model_filename);
+    InferenceServer server(mlp, options);
+    server.start();
+    std::cout << "Serving " << model_filename << " on " << options.socket_path << ": batches of up to "
+              << options.max_batch << " within " << options.max_delay.count() << " us" << std::endl;
+
+    for (;;) {
+        timespec timeout = {report_seconds > 0 ? report_seconds : 3600, 0};
+        const int signal = sigtimedwait(&signals, nullptr, &timeout);
+        if (signal == SIGINT || signal == SIGTERM) {
+            break;
+        }
+        if (report_seconds > 0) {
+            report(server.stats());
+        }
+    }
+
+    server.stop();
+    report(server.stats());
+    return 0;
+}
@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <unistd.h>
+#include <utility>
+
+// Checkpoint.cpp
+#include "Checkpoint.hpp"
+
+TrainingState read_checkpoint_state(const std::string& filename) {
+    const ModelHeader header = read_model_header(filename);
+    std::ifstream file(filename, std::ios::binary);
+    CheckpointTrailer trailer{};
+    file.seekg(static_cast<std::streamoff>(header.payload_offset + header.payload_bytes));
+    file.read(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+    if (!file || std::memcmp(trailer.magic, kCheckpointMagic, sizeof(kCheckpointMagic)) != 0) {
+        throw std::runtime_error("Not a training checkpoint: " + filename);
+    }
+    if (trailer.version < 1 || trailer.version > kCheckpointVersion) {
+        throw std::runtime_error("Unsupported checkpoint version.");
+    }
+
+    TrainingState state;
+    state.epoch = trailer.epoch;
+    state.average_loss = trailer.average_loss;
+    state.data_seed = trailer.data_seed;
+    state.prune_block_rows = trailer.prune_block_rows;
+    state.prune_block_cols = trailer.prune_block_cols;
+    if (trailer.version >= 2) {
+        OptimizerTrailer optimizer{};
+        file.read(reinterpret_cast<char*>(&optimizer), sizeof(optimizer));
+        if (!file) {
+            throw std::runtime_error("Truncated checkpoint: " + filename);
+        }
+        state.optimizer = optimizer.optimizer;
+        state.optimizer_step = optimizer.step;
+        state.moment_floats = optimizer.moment_floats;
+        state.best_loss = optimizer.best_loss;
+        state.stale_epochs = optimizer.stale_epochs;
+        state.best_weights = trailer.version >= 4 && optimizer.best_weights != 0;
+    }
+    return state;
+}
+
+void read_checkpoint_moments(const std::string& filename, const TrainingState& state, float* moments) {
+    const ModelHeader header = read_model_header(filename);
+    std::ifstream file(filename, std::ios::binary);
+    file.seekg(static_cast<std::streamoff>(header.payload_offset + header.payload_bytes + sizeof(CheckpointTrailer) +
+                                           sizeof(OptimizerTrailer)));
+    file.read(reinterpret_cast<char*>(moments), static_cast<std::streamsize>(state.moment_floats * sizeof(float)));
+    if (!file) {
+        throw std::runtime_error("Truncated checkpoint optimizer state: " + filename);
+    }
+}
+
+void read_checkpoint_best_weights(const std::string& filename, const TrainingState& state, float* weights) {
+    if (!state.best_weights) {
+        throw std::runtime_error("Checkpoint has no best weights: " + filename);
+    }
+    const ModelHeader header = read_model_header(filename);
+    std::ifstream file(filename, std::ios::binary);
+    file.seekg(static_cast<std::streamoff>(header.payload_offset + header.payload_bytes + sizeof(CheckpointTrailer) +
+                                           sizeof(OptimizerTrailer) + state.moment_floats * sizeof(float)));
+    file.read(reinterpret_cast<char*>(weights), static_cast<std::streamsize>(header.payload_bytes));
+    if (!file) {
+        throw std::runtime_error("Truncated checkpoint best weights: " + filename);
+    }
+}
+
+Checkpointer::Checkpointer(std::string filename, ModelDescription description)
+    : filename(std::move(filename)), description(std::move(description)) {
+    writer = std::thread(&Checkpointer::writer_loop, this);
+}
+
+Checkpointer::~Checkpointer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    writer.join(); // The writer drains the pending snapshot before it exits
+}
+
+void Checkpointer::submit(const float* payload, const TrainingState& state, const float* moments,
+                          const float* best_weights) {
+    int target;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        // Fill whichever buffer the writer is not reading; an unwritten
+        // snapshot in it is stale now
+        target = writing == 0 ? 1 : 0;
+        if (pending == target) {
+            pending = -1;
+        }
+    }
+
+    Snapshot& snapshot = snapshots[target];
+    const std::size_t floats = description.header.payload_bytes / sizeof(float);
+    snapshot.payload.resize(floats); // Allocates on the first two checkpoints only
+    std::memcpy(snapshot.payload.data(), payload, description.header.payload_bytes);
+    snapshot.moments.resize(moments ? state.moment_floats : 0);
+    std::copy_n(moments, snapshot.moments.size(), snapshot.moments.data());
+    snapshot.best_weights.resize(best_weights ? floats : 0);
+    std::copy_n(best_weights, snapshot.best_weights.size(), snapshot.best_weights.data());
+    snapshot.state = state;
+    snapshot.state.moment_floats = snapshot.moments.size();
+    snapshot.state.best_weights = best_weights != nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending = target;
+    }
+    changed.notify_all();
+}
+
+void Checkpointer::finish() {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&] { return (pending < 0 && writing < 0) || error; });
+    if (error) {
+        std::exception_ptr failure = error;
+        error = nullptr;
+        std::rethrow_exception(failure);
+    }
+}
+
+void Checkpointer::writer_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        changed.wait(lock, [&] { return pending >= 0 || stopping; });
+        if (pending < 0) {
+            return; // Stopping with nothing left to write
+        }
+        writing = pending;
+        pending = -1;
+
+        lock.unlock();
+        std::exception_ptr failure;
+        try {
+            write(snapshots[writing]);
+        } catch (...) {
+            failure = std::current_exception();
+        }
+        lock.lock();
+        if (failure) {
+            error = failure;
+        }
+        writing = -1;
+        changed.notify_all();
+    }
+}
+
+void Checkpointer::write(const Snapshot& snapshot) const {
+    ModelDescription current = description;
+    current.header.checksum = model_checksum(snapshot.payload.data(), current.header.payload_bytes);
+
+    CheckpointTrailer trailer{};
+    std::memcpy(trailer.magic, kCheckpointMagic, sizeof(kCheckpointMagic));
+    trailer.version = kCheckpointVersion;
+    trailer.epoch = snapshot.state.epoch;
+    trailer.average_loss = snapshot.state.average_loss;
+    trailer.data_seed = snapshot.state.data_seed;
+    trailer.prune_block_rows = static_cast<std::uint16_t>(snapshot.state.prune_block_rows);
+    trailer.prune_block_cols = static_cast<std::uint16_t>(snapshot.state.prune_block_cols);
+
+    OptimizerTrailer optimizer{};
+    optimizer.optimizer = snapshot.state.optimizer;
+    optimizer.stale_epochs = snapshot.state.stale_epochs;
+    optimizer.step = snapshot.state.optimizer_step;
+    optimizer.moment_floats = snapshot.state.moment_floats;
+    optimizer.best_loss = snapshot.state.best_loss;
+    optimizer.best_weights = snapshot.state.best_weights ? 1 : 0;
+
+    const std::string temporary = filename + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not open " + temporary + " to write a checkpoint.");
+        }
+        write_model_description(file, current);
+        file.write(reinterpret_cast<const char*>(snapshot.payload.data()), current.header.payload_bytes);
+        file.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+        file.write(reinterpret_cast<const char*>(&optimizer), sizeof(optimizer));
+        file.write(reinterpret_cast<const char*>(snapshot.moments.data()), snapshot.moments.size() * sizeof(float));
+        file.write(reinterpret_cast<const char*>(snapshot.best_weights.data()),
+                   snapshot.best_weights.size() * sizeof(float));
+        file.close();
+        if (!file) {
+            throw std::runtime_error("Could not write checkpoint " + temporary + ".");
+        }
+    }
+
+    // Make the data durable before the rename publishes it
+    int descriptor = open(temporary.c_str(), O_RDONLY);
+    if (descriptor >= 0) {
+        fsync(descriptor);
+        close(descriptor);
+    }
+    std::filesystem::rename(temporary, filename); // Atomic on POSIX: readers see the old or the new file
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "Layer.hpp"
+#include "ModelFormat.hpp"
+
+// Training progress saved with the weights. The dataset sample order depends
+// only on its seed and the epoch number, so these fix the rest of the run.
+struct TrainingState {
+  std::uint32_t epoch = 0; // Epochs completed
+  float average_loss = 0.0f;
+  std::uint64_t data_seed = 0; // Dataset::shuffle_seed of the run
+  // Optimizer and early stopping; version 1 checkpoints read as SGD with no history
+  std::uint32_t optimizer = 0; // Optimizer value
+  std::uint64_t optimizer_step = 0;
+  std::uint64_t moment_floats = 0; // Optimizer state saved after the trailers
+  float best_loss = std::numeric_limits<float>::infinity();
+  std::uint32_t stale_epochs = 0; // Epochs since best_loss improved
+  // Version 4: the weights of the best validation epoch follow the optimizer
+  // state, so a resumed run still ends on them
+  bool best_weights = false;
+  // Tile shape of a pruned model, 0 when unpruned. The mask itself is not
+  // saved; resume rebuilds it from the all-zero tiles of the weights.
+  std::uint32_t prune_block_rows = 0;
+  std::uint32_t prune_block_cols = 0;
+};
+
+// A checkpoint is an ordinary F32 model file followed by this trailer, right
+// after the payload, so every model loader also accepts checkpoints
+constexpr char kCheckpointMagic[8] = {'M', 'L', 'P', 'C', 'K', 'P', 'T', '\0'};
+constexpr std::uint32_t kCheckpointVersion = 4;
+
+struct CheckpointTrailer {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t epoch;
+  float average_loss;
+  std::uint16_t prune_block_rows; // Version 3; zero in older checkpoints
+  std::uint16_t prune_block_cols;
+  std::uint64_t data_seed;
+};
+
+// Version 2 follows the trailer with this one and then moment_floats of
+// optimizer state in the parameter layout, slot after slot. From version 4,
+// best_weights set means a copy of the payload with the best weights follows.
+struct OptimizerTrailer {
+  std::uint32_t optimizer;
+  std::uint32_t stale_epochs;
+  std::uint64_t step;
+  std::uint64_t moment_floats;
+  float best_loss;
+  std::uint32_t best_weights; // Version 4; zero in older checkpoints
+};
+
+static_assert(sizeof(CheckpointTrailer) == 32, "Checkpoint trailer must not change size");
+static_assert(sizeof(OptimizerTrailer) == 32, "Optimizer trailer must not change size");
+
+// Reads the training state of a checkpoint; throws std::runtime_error when the
+// file is a plain model or malformed
+TrainingState read_checkpoint_state(const std::string &filename);
+// Reads the state.moment_floats of optimizer state into moments
+void read_checkpoint_moments(const std::string &filename, const TrainingState &state, float *moments);
+// Reads the saved best weights, one payload of floats, when state.best_weights is set
+void read_checkpoint_best_weights(const std::string &filename, const TrainingState &state, float *weights);
+
+// Writes checkpoints on a background thread. submit() copies the weights into
+// one of two snapshot buffers and returns; the writer saves the newest
+// snapshot to a temporary file and renames it over the checkpoint, so the
+// file on disk is always complete. When the writer falls behind, an unwritten
+// snapshot is replaced by the next one instead of stalling training.
+class Checkpointer {
+public:
+  // description is the model file layout of every submitted payload
+  Checkpointer(std::string filename, ModelDescription description);
+  ~Checkpointer(); // Writes the pending snapshot, if any
+  Checkpointer(const Checkpointer &) = delete;
+  Checkpointer &operator=(const Checkpointer &) = delete;
+
+  // Copies payload_bytes of parameters, state.moment_floats of optimizer
+  // state and, if given, payload_bytes of best weights; rethrows an earlier
+  // write failure
+  void submit(const float *payload, const TrainingState &state, const float *moments = nullptr,
+              const float *best_weights = nullptr);
+  // Returns once everything submitted is on disk; rethrows write failures
+  void finish();
+
+private:
+  struct Snapshot {
+    AlignedVector<float> payload;
+    AlignedVector<float> moments;
+    AlignedVector<float> best_weights;
+    TrainingState state;
+  };
+
+  void writer_loop();
+  void write(const Snapshot &snapshot) const;
+
+  std::string filename;
+  ModelDescription description;
+  Snapshot snapshots[2];
+  int writing = -1; // Snapshot on its way to disk
+  int pending = -1; // Newest snapshot not yet picked up by the writer
+  bool stopping = false;
+  std::exception_ptr error;
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::thread writer;
+};
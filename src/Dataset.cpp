@@ -0,0 +1,456 @@
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+// Dataset.cpp
+#include "Dataset.hpp"
+#include "MappedFile.hpp"
+#include "Tiling.hpp"
+#include "stb_image.h"
+
+namespace {
+
+const char kShardMagic[8] = {'M', 'L', 'P', 'S', 'H', 'A', 'R', 'D'};
+const std::uint32_t kShardVersion = 1;
+
+// Followed by count ShardEntry records, then the encoded images
+struct ShardHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t count;
+};
+
+bool is_image_file(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    for (const char* known : {".bmp", ".png", ".jpg", ".jpeg", ".tga", ".gif", ".psd", ".hdr", ".pic", ".pgm", ".ppm", ".pnm"}) {
+        if (extension == known) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+std::vector<std::string> list_image_files(const std::string& directory) {
+    std::vector<std::string> files;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.is_regular_file() && is_image_file(entry.path())) {
+            files.push_back(entry.path().string());
+        }
+    }
+    std::sort(files.begin(), files.end()); // Directory order is unspecified
+    return files;
+}
+
+MemoryDataset::MemoryDataset(const std::vector<std::vector<float>>& inputs, const std::vector<std::vector<float>>& labels) {
+    if (inputs.empty() || inputs.size() != labels.size()) {
+        throw std::invalid_argument("Training needs at least one sample and a label for every input.");
+    }
+    input_width = static_cast<int>(inputs.front().size());
+    label_width = static_cast<int>(labels.front().size());
+    for (size_t sample = 0; sample < inputs.size(); ++sample) {
+        if (inputs[sample].size() != inputs.front().size() || labels[sample].size() != labels.front().size()) {
+            throw std::invalid_argument("Every sample and every label must have the same size.");
+        }
+        input_rows.push_back(inputs[sample].data());
+        label_rows.push_back(labels[sample].data());
+    }
+}
+
+MemoryDataset MemoryDataset::split_tail(size_t count) {
+    if (count >= input_rows.size()) {
+        throw std::invalid_argument("A split must leave at least one sample behind.");
+    }
+    MemoryDataset tail;
+    tail.input_width = input_width;
+    tail.label_width = label_width;
+    const size_t first = input_rows.size() - count;
+    tail.input_rows.assign(input_rows.begin() + first, input_rows.end());
+    tail.label_rows.assign(label_rows.begin() + first, label_rows.end());
+    input_rows.resize(first);
+    label_rows.resize(first);
+    return tail;
+}
+
+void MemoryDataset::start_epoch(int, size_t batch_size) {
+    position = 0;
+    this->batch_size = batch_size;
+}
+
+bool MemoryDataset::next(Batch& batch) {
+    if (position >= input_rows.size()) {
+        return false;
+    }
+    const size_t count = std::min(batch_size, input_rows.size() - position);
+    batch.inputs = std::span<const float* const>(input_rows.data() + position, count);
+    batch.labels = std::span<const float* const>(label_rows.data() + position, count);
+    batch.count = static_cast<int>(count);
+    position += count;
+    return true;
+}
+
+ImageDataset::ImageDataset(const std::string& path, DatasetOptions options) : options(options), path(path) {
+    if (options.patch < 0 || options.decode_threads < 1) {
+        throw std::invalid_argument("Patch size must not be negative and at least one decode thread is needed.");
+    }
+
+    if (std::filesystem::is_directory(path)) {
+        sources = list_image_files(path);
+    } else {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not open dataset " + path + ".");
+        }
+        char magic[sizeof(kShardMagic)] = {};
+        file.read(magic, sizeof(magic));
+        if (file && std::memcmp(magic, kShardMagic, sizeof(magic)) == 0) {
+            open_shard();
+        } else {
+            sources.push_back(path); // A single image
+        }
+    }
+    if (image_count() == 0) {
+        throw std::invalid_argument("No images found in " + path + ".");
+    }
+
+    // The first image fixes the sample size of whole-image datasets
+    int channels = 0;
+    const bool known = shard ? stbi_info_from_memory(shard->data() + shard_entries[0].offset,
+                                                     static_cast<int>(shard_entries[0].bytes), &width, &height, &channels)
+                             : stbi_info(sources[0].c_str(), &width, &height, &channels);
+    if (!known) {
+        throw std::runtime_error("Could not read image " + image_name(0) + ".");
+    }
+    sample_size = options.patch > 0 ? options.patch * options.patch : width * height;
+}
+
+ImageDataset::~ImageDataset() {
+    stop();
+}
+
+void ImageDataset::open_shard() {
+    shard = std::make_unique<MappedFile>(path);
+    ShardHeader header;
+    if (shard->size() < sizeof(header)) {
+        throw std::runtime_error("Truncated shard header in " + path + ".");
+    }
+    std::memcpy(&header, shard->data(), sizeof(header));
+    if (header.version != kShardVersion) {
+        throw std::runtime_error("Unsupported shard version in " + path + ".");
+    }
+    const size_t table_bytes = static_cast<size_t>(header.count) * sizeof(ShardEntry);
+    if (shard->size() - sizeof(header) < table_bytes) {
+        throw std::runtime_error("Truncated shard table in " + path + ".");
+    }
+    shard_entries.resize(header.count);
+    std::memcpy(shard_entries.data(), shard->data() + sizeof(header), table_bytes);
+    for (const ShardEntry& entry : shard_entries) {
+        if (entry.offset > shard->size() || entry.bytes > shard->size() - entry.offset || entry.bytes > INT32_MAX) {
+            throw std::runtime_error("Shard entry runs past the end of " + path + ".");
+        }
+    }
+}
+
+std::string ImageDataset::image_name(size_t image) const {
+    return shard ? path + "#" + std::to_string(image) : sources[image];
+}
+
+void ImageDataset::start_epoch(int epoch, size_t batch_size) {
+    if (batch_size < 1) {
+        throw std::invalid_argument("Batch size must be at least one.");
+    }
+    stop();
+    this->batch_size = batch_size;
+
+    // Visit images in a fresh order every epoch unless shuffling is off
+    order.resize(image_count());
+    std::iota(order.begin(), order.end(), size_t{0});
+    if (options.shuffle_buffer > 0) {
+        std::mt19937_64 rng(options.seed + epoch);
+        std::shuffle(order.begin(), order.end(), rng);
+    }
+
+    decoded.assign(2 * options.decode_threads, Decoded{});
+    next_decode = 0;
+    next_consume = 0;
+    const size_t stride = aligned_floats(sample_size);
+    for (BatchBuffer& buffer : buffers) {
+        buffer.samples.resize(batch_size * stride);
+        buffer.rows.resize(batch_size);
+        for (size_t row = 0; row < batch_size; ++row) {
+            buffer.rows[row] = buffer.samples.data() + row * stride;
+        }
+        buffer.count = 0;
+        buffer.full = false;
+    }
+    fill_index = 0;
+    serve_index = 0;
+    served = -1;
+    stopping = false;
+    finished = false;
+    error = nullptr;
+
+    for (int thread = 0; thread < options.decode_threads; ++thread) {
+        threads.emplace_back(&ImageDataset::decode_loop, this);
+    }
+    threads.emplace_back(&ImageDataset::assemble_loop, this, epoch);
+}
+
+bool ImageDataset::next(Batch& batch) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (served >= 0) { // The trainer is done with the previous batch
+        buffers[served].full = false;
+        served = -1;
+        changed.notify_all();
+    }
+    changed.wait(lock, [&] { return error || buffers[serve_index].full || finished; });
+    if (error) {
+        std::exception_ptr failure = error;
+        lock.unlock();
+        stop();
+        std::rethrow_exception(failure);
+    }
+    if (!buffers[serve_index].full) {
+        return false; // Finished, and the last batch has been served
+    }
+
+    served = serve_index;
+    serve_index ^= 1;
+    const BatchBuffer& buffer = buffers[served];
+    batch.inputs = std::span<const float* const>(buffer.rows.data(), buffer.count);
+    batch.labels = batch.inputs; // Reconstruction: every sample is its own label
+    batch.count = buffer.count;
+    return true;
+}
+
+void ImageDataset::decode_loop() {
+    for (;;) {
+        size_t position;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            // Decoders may run ahead of the assembler by the size of the ring
+            changed.wait(lock, [&] {
+                return stopping || next_decode >= order.size() || next_decode < next_consume + decoded.size();
+            });
+            if (stopping || next_decode >= order.size()) {
+                return;
+            }
+            position = next_decode++;
+        }
+
+        std::vector<float> samples;
+        try {
+            samples = decode(order[position]);
+        } catch (...) {
+            fail(std::current_exception());
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        Decoded& slot = decoded[position % decoded.size()];
+        slot.samples = std::move(samples);
+        slot.ready = true;
+        changed.notify_all();
+    }
+}
+
+void ImageDataset::assemble_loop(int epoch) {
+    try {
+        std::mt19937_64 rng(~(options.seed + epoch)); // Independent of the image order stream
+        const size_t capacity = options.shuffle_buffer;
+        const size_t stride = aligned_floats(sample_size);
+        size_t held_count = 0; // Samples in the shuffle buffer, one per row of held
+        BatchBuffer* buffer = nullptr;
+
+        // Copies one sample into the batch being filled, handing full batches to the trainer
+        auto emit = [&](const float* sample) {
+            if (!buffer) {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return stopping || (!buffers[fill_index].full && served != fill_index); });
+                if (stopping) {
+                    return false;
+                }
+                buffer = &buffers[fill_index];
+                buffer->count = 0;
+            }
+            std::copy_n(sample, sample_size, buffer->samples.data() + buffer->count++ * stride);
+            if (static_cast<size_t>(buffer->count) == batch_size) {
+                std::lock_guard<std::mutex> lock(mutex);
+                buffer->full = true;
+                fill_index ^= 1;
+                buffer = nullptr;
+                changed.notify_all();
+            }
+            return true;
+        };
+
+        for (size_t position = 0; position < order.size(); ++position) {
+            std::vector<float> samples;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                Decoded& slot = decoded[position % decoded.size()];
+                changed.wait(lock, [&] { return stopping || slot.ready; });
+                if (stopping) {
+                    return;
+                }
+                samples = std::move(slot.samples);
+                slot.ready = false;
+                ++next_consume;
+                changed.notify_all();
+            }
+
+            for (size_t offset = 0; offset < samples.size(); offset += sample_size) {
+                const float* sample = samples.data() + offset;
+                if (capacity == 0) {
+                    if (!emit(sample)) {
+                        return;
+                    }
+                } else if (held_count < capacity) {
+                    // The buffer grows to what the data fills, so a small dataset never
+                    // pays for the full capacity; later epochs reuse it
+                    if (held.size() < (held_count + 1) * sample_size) {
+                        held.reserve(std::min(capacity, 2 * held_count + 1) * sample_size);
+                        held.resize((held_count + 1) * sample_size);
+                    }
+                    std::copy_n(sample, sample_size, held.data() + held_count++ * sample_size);
+                } else {
+                    // Emit a random held sample and take its place
+                    float* victim = held.data() + rng() % capacity * sample_size;
+                    if (!emit(victim)) {
+                        return;
+                    }
+                    std::copy_n(sample, sample_size, victim);
+                }
+            }
+        }
+
+        // Drain the shuffle buffer in random order
+        while (held_count > 0) {
+            float* victim = held.data() + rng() % held_count * sample_size;
+            if (!emit(victim)) {
+                return;
+            }
+            std::copy_n(held.data() + --held_count * sample_size, sample_size, victim);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (buffer && buffer->count > 0) { // Short final batch
+            buffer->full = true;
+            fill_index ^= 1;
+        }
+        finished = true;
+        changed.notify_all();
+    } catch (...) {
+        fail(std::current_exception());
+    }
+}
+
+std::vector<float> ImageDataset::decode(size_t image) const {
+    int image_width = 0;
+    int image_height = 0;
+    int channels = 0;
+    unsigned char* data = shard ? stbi_load_from_memory(shard->data() + shard_entries[image].offset,
+                                                        static_cast<int>(shard_entries[image].bytes),
+                                                        &image_width, &image_height, &channels, 1)
+                                : stbi_load(sources[image].c_str(), &image_width, &image_height, &channels, 1); // Grayscale
+    if (data == nullptr) {
+        throw std::runtime_error("Could not decode image " + image_name(image) + ".");
+    }
+    std::vector<float> pixels(static_cast<size_t>(image_width) * image_height);
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        pixels[i] = data[i] / 255.0f; // Normalize pixel values to [0, 1]
+    }
+    stbi_image_free(data);
+
+    if (options.patch == 0) {
+        if (image_width != width || image_height != height) {
+            throw std::runtime_error("Image " + image_name(image) + " differs in size from the first image; "
+                                     "whole-image datasets need every image the same size.");
+        }
+        return pixels;
+    }
+
+    const int patch = options.patch;
+    const std::vector<int> xs = tile_positions(image_width, patch, patch / 2);
+    const std::vector<int> ys = tile_positions(image_height, patch, patch / 2);
+    std::vector<float> samples(xs.size() * ys.size() * sample_size);
+    float* out = samples.data();
+    for (int y : ys) {
+        for (int x : xs) {
+            extract_patch(pixels.data(), image_width, image_height, x, y, patch, out);
+            out += sample_size;
+        }
+    }
+    return samples;
+}
+
+void ImageDataset::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        changed.notify_all();
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+}
+
+void ImageDataset::fail(std::exception_ptr failure) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!error) {
+        error = failure;
+    }
+    stopping = true; // Wind down the other pipeline threads
+    changed.notify_all();
+}
+
+void pack_image_shard(const std::vector<std::string>& files, const std::string& shard) {
+    std::ofstream out(shard, std::ios::binary);
+    if (!out.is_open()) {
+        throw std::runtime_error("Could not open shard " + shard + " for writing.");
+    }
+
+    ShardHeader header;
+    std::memcpy(header.magic, kShardMagic, sizeof(kShardMagic));
+    header.version = kShardVersion;
+    header.count = static_cast<std::uint32_t>(files.size());
+    std::vector<ShardEntry> entries(files.size());
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(entries[0]));
+
+    std::uint64_t offset = sizeof(header) + entries.size() * sizeof(entries[0]);
+    std::vector<char> bytes;
+    for (size_t i = 0; i < files.size(); ++i) {
+        std::ifstream file(files[i], std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not open image " + files[i] + ".");
+        }
+        bytes.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(bytes.data(), bytes.size());
+        int width, height, channels;
+        if (!file || !stbi_info_from_memory(reinterpret_cast<const unsigned char*>(bytes.data()),
+                                            static_cast<int>(bytes.size()), &width, &height, &channels)) {
+            throw std::invalid_argument("Not a readable image: " + files[i] + ".");
+        }
+        out.write(bytes.data(), bytes.size());
+        entries[i] = {offset, bytes.size()};
+        offset += bytes.size();
+    }
+
+    // Fill in the table now that every offset is known
+    out.seekp(sizeof(header));
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(entries[0]));
+    if (!out) {
+        throw std::runtime_error("Could not write shard " + shard + ".");
+    }
+}
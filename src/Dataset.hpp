@@ -0,0 +1,155 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Layer.hpp"
+
+class MappedFile;
+
+// One mini-batch as row pointers; rows stay valid until the next call to
+// Dataset::next on the same dataset
+struct Batch {
+  std::span<const float *const> inputs;
+  std::span<const float *const> labels;
+  int count = 0;
+};
+
+// A stream of mini-batches, one pass over the data per epoch
+class Dataset {
+public:
+  virtual ~Dataset() = default;
+
+  virtual int input_size() const = 0;
+  virtual int label_size() const = 0;
+  // Rewinds to the start of the data; the sample order depends only on the
+  // epoch number, so an epoch can be replayed exactly
+  virtual void start_epoch(int epoch, std::size_t batch_size) = 0;
+  // Fills batch with up to batch_size samples; false once the epoch is exhausted
+  virtual bool next(Batch &batch) = 0;
+  // Seed that, with the epoch number, fixes the sample order; saved in checkpoints
+  virtual std::uint64_t shuffle_seed() const { return 0; }
+};
+
+// Samples already in memory, served in order without copying. The vectors
+// must outlive the dataset.
+class MemoryDataset : public Dataset {
+public:
+  MemoryDataset(const std::vector<std::vector<float>> &inputs,
+                const std::vector<std::vector<float>> &labels);
+
+  int input_size() const override { return input_width; }
+  int label_size() const override { return label_width; }
+  void start_epoch(int epoch, std::size_t batch_size) override;
+  bool next(Batch &batch) override;
+  std::size_t size() const { return input_rows.size(); }
+  // Moves the last count samples into a new dataset, e.g. as a validation split
+  MemoryDataset split_tail(std::size_t count);
+
+private:
+  MemoryDataset() = default;
+
+  int input_width = 0;
+  int label_width = 0;
+  std::vector<const float *> input_rows;
+  std::vector<const float *> label_rows;
+  std::size_t position = 0;
+  std::size_t batch_size = 1;
+};
+
+// Where one encoded image sits inside a shard file
+struct ShardEntry {
+  std::uint64_t offset;
+  std::uint64_t bytes;
+};
+
+struct DatasetOptions {
+  int patch = 0;                   // Cut images into patch x patch tiles at half-patch spacing; 0 keeps whole images
+  int decode_threads = 2;          // Background stb_image decoders
+  std::size_t shuffle_buffer = 4096; // Samples held for shuffling; 0 keeps file order
+  std::uint64_t seed = 1;          // Combined with the epoch number for the shuffle order
+};
+
+// Grayscale images streamed from a directory, a single image file or a shard
+// packed by pack_image_shard. Decoder threads turn images into [0, 1] floats,
+// an assembler thread shuffles samples through a bounded buffer and fills
+// batches, and two batch buffers alternate between the assembler and the
+// trainer, so decoding overlaps training. Memory stays bounded by the shuffle
+// buffer, a few decoded images and two batches, whatever the dataset size.
+// Samples are their own labels, as the network is trained to reconstruct.
+class ImageDataset : public Dataset {
+public:
+  explicit ImageDataset(const std::string &path, DatasetOptions options = {});
+  ~ImageDataset() override;
+  ImageDataset(const ImageDataset &) = delete;
+  ImageDataset &operator=(const ImageDataset &) = delete;
+
+  std::size_t image_count() const { return shard ? shard_entries.size() : sources.size(); }
+  int input_size() const override { return sample_size; }
+  int label_size() const override { return sample_size; }
+  void start_epoch(int epoch, std::size_t batch_size) override;
+  bool next(Batch &batch) override;
+  std::uint64_t shuffle_seed() const override { return options.seed; }
+
+private:
+  struct Decoded {
+    std::vector<float> samples; // Every sample cut from one image, back to back
+    bool ready = false;
+  };
+  struct BatchBuffer {
+    AlignedVector<float> samples;
+    std::vector<const float *> rows;
+    int count = 0;
+    bool full = false;
+  };
+
+  void open_shard();
+  std::string image_name(std::size_t image) const;
+  void decode_loop();
+  void assemble_loop(int epoch);
+  std::vector<float> decode(std::size_t image) const;
+  void stop();
+  void fail(std::exception_ptr failure);
+
+  DatasetOptions options;
+  std::string path;
+  std::vector<std::string> sources; // File names, empty for a shard
+  std::unique_ptr<MappedFile> shard;
+  std::vector<ShardEntry> shard_entries;
+  int width = 0;
+  int height = 0;
+  int sample_size = 0;
+  std::size_t batch_size = 1;
+
+  std::vector<std::size_t> order;    // Image order for the current epoch
+  std::vector<Decoded> decoded;      // Ring of decoded images, indexed by position in order
+  std::vector<float> held;           // Shuffle buffer, one sample per row; only the assembler touches it
+  std::size_t next_decode = 0;       // Next position a decoder claims
+  std::size_t next_consume = 0;      // Next position the assembler takes
+  BatchBuffer buffers[2];
+  int fill_index = 0;    // Buffer the assembler fills next
+  int serve_index = 0;   // Buffer the trainer reads next
+  int served = -1;       // Buffer handed out by the last next(), released on the following call
+  bool stopping = false;
+  bool finished = true; // Assembler has queued its last batch; nothing runs before start_epoch
+  std::exception_ptr error;
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::vector<std::thread> threads;
+};
+
+// Image files directly inside directory, by extension, in name order; the
+// files a directory dataset reads
+std::vector<std::string> list_image_files(const std::string &directory);
+
+// Packs encoded images into one shard file: a header, an offset table and
+// the encoded files back to back, so a dataset can be read with one mapping
+void pack_image_shard(const std::vector<std::string> &files, const std::string &shard);
@@ -0,0 +1,197 @@
+#include <algorithm>
+
+// Gemm.cpp
+#include "Gemm.hpp"
+#include "Kernels.hpp"
+#include "Layer.hpp"
+
+namespace {
+
+// Cache blocks around the register tile of the active micro-kernel.
+// KC x NR panels of B stay in L1, MC x KC blocks of A in L2, KC x NC in L3.
+// MC and NC are multiples of every ISA's tile.
+constexpr int MC = 96;
+constexpr int KC = 256;
+constexpr int NC = 2048;
+// Below this many rows of A, packing op(B) for the micro-kernel costs more
+// than it saves; small inference batches stream B instead
+constexpr int kStreamRows = 32;
+
+// Per-thread packing buffers; they grow to their largest size once and are then reused
+thread_local AlignedVector<float> packed_a;
+thread_local AlignedVector<float> packed_b;
+
+// Copies op(A)[rows x depth] into mr-row micro-panels stored column by column,
+// zero-padding the last panel so the micro-kernel never needs an edge case
+void pack_a(Transpose trans, const float* a, std::size_t lda, int rows, int depth, int mr, float* out) {
+    for (int i0 = 0; i0 < rows; i0 += mr) {
+        const int height = std::min(mr, rows - i0);
+        for (int p = 0; p < depth; ++p) {
+            for (int i = 0; i < mr; ++i) {
+                float value = 0.0f;
+                if (i < height) {
+                    value = trans == Transpose::No ? a[(i0 + i) * lda + p] : a[p * lda + i0 + i];
+                }
+                *out++ = value;
+            }
+        }
+    }
+}
+
+// Copies op(B)[depth x cols] into nr-column micro-panels stored row by row
+void pack_b(Transpose trans, const float* b, std::size_t ldb, int depth, int cols, int nr, float* out) {
+    for (int j0 = 0; j0 < cols; j0 += nr) {
+        const int width = std::min(nr, cols - j0);
+        for (int p = 0; p < depth; ++p) {
+            if (trans == Transpose::No && width == nr) {
+                std::copy_n(b + p * ldb + j0, nr, out);
+                out += nr;
+                continue;
+            }
+            for (int j = 0; j < nr; ++j) {
+                float value = 0.0f;
+                if (j < width) {
+                    value = trans == Transpose::No ? b[p * ldb + j0 + j] : b[(j0 + j) * ldb + p];
+                }
+                *out++ = value;
+            }
+        }
+    }
+}
+
+void scale_rows(int m, int n, float beta, float* c, std::size_t ldc) {
+    if (beta == 1.0f) {
+        return;
+    }
+    for (int i = 0; i < m; ++i) {
+        for (int j = 0; j < n; ++j) {
+            c[i * ldc + j] = beta == 0.0f ? 0.0f : beta * c[i * ldc + j];
+        }
+    }
+}
+
+// Single-row product (one sample): packing op(B) would copy the whole matrix
+// for a single use, so stream it directly instead
+void gemv_row(Transpose trans_a, Transpose trans_b, int n, int k, float alpha,
+              const float* a, std::size_t lda, const float* b, std::size_t ldb,
+              float beta, float* c) {
+    const std::size_t a_step = trans_a == Transpose::No ? 1 : lda;
+    if (trans_b == Transpose::Yes && a_step == 1) { // c[j] = alpha * <a, row j of B>
+        for (int j = 0; j < n; ++j) {
+            const float sum = kernels::dot(a, b + j * ldb, k);
+            c[j] = beta == 0.0f ? alpha * sum : alpha * sum + beta * c[j];
+        }
+        return;
+    }
+    if (trans_b == Transpose::Yes) {
+        for (int j = 0; j < n; ++j) {
+            const float* b_row = b + j * ldb;
+            float sum = 0.0f;
+            for (int p = 0; p < k; ++p) {
+                sum += a[p * a_step] * b_row[p];
+            }
+            c[j] = beta == 0.0f ? alpha * sum : alpha * sum + beta * c[j];
+        }
+        return;
+    }
+    scale_rows(1, n, beta, c, 0); // c += alpha * a[p] * row p of B
+    for (int p = 0; p < k; ++p) {
+        kernels::axpy(alpha * a[p * a_step], b + p * ldb, c, n);
+    }
+}
+
+// A few rows against B^T (a small inference batch): each row of B is loaded
+// once and dotted with every row of A while it is still in L1
+void stream_rows(int m, int n, int k, float alpha, const float* a, std::size_t lda,
+                 const float* b, std::size_t ldb, float beta, float* c, std::size_t ldc) {
+    for (int j = 0; j < n; ++j) {
+        const float* b_row = b + j * ldb;
+        for (int i = 0; i < m; ++i) {
+            const float sum = kernels::dot(a + i * lda, b_row, k);
+            float& out = c[i * ldc + j];
+            out = beta == 0.0f ? alpha * sum : alpha * sum + beta * out;
+        }
+    }
+}
+
+// Rank-1 update (a one-sample weight gradient): C += alpha * column(A) * row(B)
+void rank_one(Transpose trans_a, int m, int n, float alpha, const float* a,
+              std::size_t lda, const float* b, float beta, float* c, std::size_t ldc) {
+    scale_rows(m, n, beta, c, ldc);
+    const std::size_t a_step = trans_a == Transpose::No ? lda : 1;
+    for (int i = 0; i < m; ++i) {
+        kernels::axpy(alpha * a[i * a_step], b, c + i * ldc, n);
+    }
+}
+
+} // namespace
+
+void gemm(Transpose trans_a, Transpose trans_b, int m, int n, int k,
+          float alpha, const float* a, std::size_t lda, const float* b,
+          std::size_t ldb, float beta, float* c, std::size_t ldc) {
+    if (m <= 0 || n <= 0) {
+        return;
+    }
+    if (k <= 0 || alpha == 0.0f) {
+        scale_rows(m, n, beta, c, ldc);
+        return;
+    }
+    if (m == 1) {
+        gemv_row(trans_a, trans_b, n, k, alpha, a, lda, b, ldb, beta, c);
+        return;
+    }
+    if (m < kStreamRows && trans_a == Transpose::No && trans_b == Transpose::Yes) {
+        stream_rows(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+        return;
+    }
+    if (k == 1 && trans_b == Transpose::No) {
+        rank_one(trans_a, m, n, alpha, a, lda, b, beta, c, ldc);
+        return;
+    }
+
+    const kernels::MicroKernel& kernel = kernels::micro_kernel();
+    const int mr = kernel.mr;
+    const int nr = kernel.nr;
+    reserve_gemm_buffers();
+
+    for (int j0 = 0; j0 < n; j0 += NC) {
+        const int nc = std::min(NC, n - j0);
+        for (int p0 = 0; p0 < k; p0 += KC) {
+            const int kc = std::min(KC, k - p0);
+            // The first depth block applies beta, later ones accumulate
+            const float block_beta = p0 == 0 ? beta : 1.0f;
+            const float* b_block = trans_b == Transpose::No ? b + p0 * ldb + j0 : b + j0 * ldb + p0;
+            pack_b(trans_b, b_block, ldb, kc, nc, nr, packed_b.data());
+
+            for (int i0 = 0; i0 < m; i0 += MC) {
+                const int mc = std::min(MC, m - i0);
+                const float* a_block = trans_a == Transpose::No ? a + i0 * lda + p0 : a + p0 * lda + i0;
+                pack_a(trans_a, a_block, lda, mc, kc, mr, packed_a.data());
+
+                for (int jr = 0; jr < nc; jr += nr) {
+                    const int width = std::min(nr, nc - jr);
+                    const float* b_panel = packed_b.data() + static_cast<std::size_t>(jr) * kc;
+                    for (int ir = 0; ir < mc; ir += mr) {
+                        const int height = std::min(mr, mc - ir);
+                        alignas(kLayerAlignment) float acc[kernels::kMaxMR * kernels::kMaxNR];
+                        kernel.run(kc, packed_a.data() + static_cast<std::size_t>(ir) * kc, b_panel, acc);
+
+                        float* c_tile = c + (i0 + ir) * ldc + j0 + jr;
+                        for (int i = 0; i < height; ++i) {
+                            float* c_row = c_tile + i * ldc;
+                            const float* acc_row = acc + i * nr;
+                            for (int j = 0; j < width; ++j) {
+                                c_row[j] = block_beta == 0.0f ? alpha * acc_row[j] : alpha * acc_row[j] + block_beta * c_row[j];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void reserve_gemm_buffers() {
+    packed_a.resize(static_cast<std::size_t>(MC + kernels::kMaxMR) * KC);
+    packed_b.resize(static_cast<std::size_t>(NC + kernels::kMaxNR) * KC);
+}
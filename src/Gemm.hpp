@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+
+enum class Transpose { No, Yes };
+
+// Single-precision GEMM on row-major matrices:
+//   C[m x n] = alpha * op(A)[m x k] * op(B)[k x n] + beta * C
+// op(X) is X or its transpose; ld* are row strides in floats. When beta is
+// zero C is write-only, so it may start uninitialized.
+void gemm(Transpose trans_a, Transpose trans_b, int m, int n, int k,
+          float alpha, const float *a, std::size_t lda, const float *b,
+          std::size_t ldb, float beta, float *c, std::size_t ldc);
+
+// Sizes the calling thread's packing buffers up front, so its first packed
+// gemm does not allocate
+void reserve_gemm_buffers();
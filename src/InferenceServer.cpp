@@ -0,0 +1,414 @@
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// InferenceServer.cpp
+#include "InferenceServer.hpp"
+#include "MLP.hpp"
+#include "ThreadPool.hpp"
+
+namespace {
+
+constexpr int kListenBacklog = 128;
+// Finished readers are joined at least this often, even when no client connects
+constexpr int kReapIntervalMs = 1000;
+
+sockaddr_un socket_address(const std::string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path must have 1 to " + std::to_string(sizeof(address.sun_path) - 1) + " characters.");
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+// Reads exactly bytes; false on end of stream or error
+bool receive_all(int descriptor, void* data, std::size_t bytes) {
+    char* cursor = static_cast<char*>(data);
+    while (bytes > 0) {
+        const ssize_t received = recv(descriptor, cursor, bytes, MSG_WAITALL);
+        if (received <= 0) {
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        cursor += received;
+        bytes -= static_cast<std::size_t>(received);
+    }
+    return true;
+}
+
+// Sends a header and its payload in one gathered write, without joining them
+bool send_message(int descriptor, const void* header, std::size_t header_bytes, const void* payload, std::size_t payload_bytes) {
+    iovec parts[2] = {{const_cast<void*>(header), header_bytes}, {const_cast<void*>(payload), payload_bytes}};
+    msghdr message{};
+    message.msg_iov = parts;
+    message.msg_iovlen = payload_bytes > 0 ? 2 : 1;
+    while (message.msg_iovlen > 0) {
+        const ssize_t sent = sendmsg(descriptor, &message, MSG_NOSIGNAL); // A closed peer is an error, not SIGPIPE
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        // Skip what went out; partial writes only happen on large payloads
+        std::size_t done = static_cast<std::size_t>(sent);
+        while (message.msg_iovlen > 0 && done >= message.msg_iov->iov_len) {
+            done -= message.msg_iov->iov_len;
+            ++message.msg_iov;
+            --message.msg_iovlen;
+        }
+        if (message.msg_iovlen > 0) {
+            message.msg_iov->iov_base = static_cast<char*>(message.msg_iov->iov_base) + done;
+            message.msg_iov->iov_len -= done;
+        }
+    }
+    return true;
+}
+
+std::uint8_t to_pixel(float value) {
+    return static_cast<std::uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+}
+
+} // namespace
+
+double latency_percentile(std::vector<float>& samples, double q) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    const std::size_t index = std::min(samples.size() - 1, static_cast<std::size_t>(q * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+InferenceServer::InferenceServer(const MLP& model, ServerOptions options) : model(model), options(std::move(options)) {
+    if (this->options.max_batch < 1 || this->options.max_delay.count() < 0) {
+        throw std::invalid_argument("The batch size must be positive and the delay not negative.");
+    }
+    if (this->options.workers < 1) {
+        this->options.workers = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+}
+
+InferenceServer::~InferenceServer() {
+    stop();
+}
+
+void InferenceServer::start() {
+    if (listener >= 0) {
+        throw std::runtime_error("The server is already running.");
+    }
+    const sockaddr_un address = socket_address(options.socket_path);
+    listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0); // So accept cannot block after poll
+    if (listener < 0) {
+        throw std::runtime_error("Could not create a Unix socket.");
+    }
+    unlink(options.socket_path.c_str()); // A stale socket from an earlier run
+    if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, kListenBacklog) != 0) {
+        close(listener);
+        listener = -1;
+        throw std::runtime_error("Could not listen on " + options.socket_path + ": " + std::strerror(errno));
+    }
+
+    stopping = false;
+    started = std::chrono::steady_clock::now();
+    latencies.assign(kLatencyWindow, 0.0f);
+    requests = batches = rejected = 0;
+    workspaces.clear();
+    for (int worker = 0; worker < options.workers; ++worker) {
+        workspaces.emplace_back(model.topology(), options.max_batch); // Serving never allocates after this
+    }
+    pool = std::make_unique<ThreadPool>(options.workers);
+    dispatcher = std::thread([this] { pool->run([this](int worker) { worker_loop(worker); }); });
+    acceptor = std::thread(&InferenceServer::accept_loop, this);
+}
+
+void InferenceServer::stop() {
+    if (listener < 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    queued.notify_all();
+
+    shutdown(listener, SHUT_RDWR); // Wakes accept
+    acceptor.join();
+    close(listener);
+    listener = -1;
+    unlink(options.socket_path.c_str());
+
+    // Readers see end of stream; one waiting on a queued request gets its
+    // reply first, since the workers drain the queue before exiting
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        for (Connection& connection : connections) {
+            shutdown(connection.descriptor, SHUT_RDWR);
+        }
+    }
+    for (Connection& connection : connections) {
+        connection.reader.join();
+        close(connection.descriptor);
+    }
+    connections.clear();
+    dispatcher.join();
+    pool.reset();
+}
+
+ServerStats InferenceServer::stats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    ServerStats result;
+    result.requests = requests;
+    result.batches = batches;
+    result.rejected = rejected;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    result.requests_per_second = result.seconds > 0.0 ? requests / result.seconds : 0.0;
+    result.mean_batch = batches > 0 ? static_cast<double>(requests) / batches : 0.0;
+    std::vector<float> window(latencies.begin(), latencies.begin() + std::min<std::uint64_t>(requests, kLatencyWindow));
+    result.p50_us = latency_percentile(window, 0.50);
+    result.p99_us = latency_percentile(window, 0.99);
+    return result;
+}
+
+void InferenceServer::accept_loop() {
+    for (;;) {
+        // Wake on a new connection, a shut down listener or the reap timer
+        pollfd listening = {listener, POLLIN, 0};
+        const int ready = poll(&listening, 1, kReapIntervalMs);
+        reap_connections();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) {
+                return; // A shut down listener can keep polling ready without accept failing
+            }
+        }
+        if (ready == 0 || (ready < 0 && errno == EINTR)) {
+            continue;
+        }
+        const int descriptor = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (descriptor < 0) {
+            if (errno == EINTR || errno == ECONNABORTED || errno == EAGAIN) {
+                continue;
+            }
+            return; // The listener was shut down
+        }
+
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        Connection& connection = connections.emplace_back();
+        connection.descriptor = descriptor;
+        connection.reader = std::thread(&InferenceServer::serve, this, std::ref(connection));
+    }
+}
+
+void InferenceServer::reap_connections() {
+    std::lock_guard<std::mutex> lock(connections_mutex);
+    for (auto it = connections.begin(); it != connections.end();) {
+        if (it->closed.load(std::memory_order_acquire)) {
+            it->reader.join();
+            close(it->descriptor);
+            it = connections.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void InferenceServer::serve(Connection& connection) {
+    const int descriptor = connection.descriptor;
+    Request& request = connection.request;
+    const std::uint32_t inputs = static_cast<std::uint32_t>(model.topology().front());
+    const std::uint32_t outputs = static_cast<std::uint32_t>(model.topology().back());
+    request.input.resize(inputs);
+    request.output.resize(outputs);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++receiving;
+    }
+    const ServerHello hello = {kServerMagic, inputs, outputs, static_cast<std::uint32_t>(options.max_batch)};
+    bool open = send_message(descriptor, &hello, sizeof(hello), nullptr, 0);
+    while (open) {
+        RequestHeader header;
+        if (!receive_all(descriptor, &header, sizeof(header)) || header.magic != kRequestMagic) {
+            break;
+        }
+        const SampleFormat format = static_cast<SampleFormat>(header.format);
+        if (header.count != inputs || (format != SampleFormat::F32 && format != SampleFormat::U8)) {
+            // The payload length cannot be trusted, so reject and hang up
+            const ResponseHeader reply = {kResponseMagic, static_cast<std::uint32_t>(ResponseStatus::BadRequest), 0, 0};
+            send_message(descriptor, &reply, sizeof(reply), nullptr, 0);
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            ++rejected;
+            break;
+        }
+        if (format == SampleFormat::F32) {
+            // Into the request buffer; predict_rows copies it into the worker's
+            // workspace, as the batch it joins is not known yet
+            open = receive_all(descriptor, request.input.data(), inputs * sizeof(float));
+        } else {
+            request.pixels.resize(std::max(inputs, outputs));
+            open = receive_all(descriptor, request.pixels.data(), inputs);
+            for (std::uint32_t i = 0; i < inputs && open; ++i) {
+                request.input[i] = request.pixels[i] / 255.0f;
+            }
+        }
+        if (!open) {
+            break;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (stopping) {
+                break;
+            }
+            request.arrival = std::chrono::steady_clock::now();
+            request.done = false;
+            queue.push_back(&request);
+            --receiving;
+            queued.notify_one();
+            request.finished.wait(lock, [&] { return request.done; });
+            ++receiving;
+        }
+
+        const ResponseHeader reply = {kResponseMagic, static_cast<std::uint32_t>(ResponseStatus::Ok), outputs, 0};
+        if (format == SampleFormat::F32) {
+            open = send_message(descriptor, &reply, sizeof(reply), request.output.data(), outputs * sizeof(float));
+        } else {
+            std::transform(request.output.begin(), request.output.end(), request.pixels.begin(), to_pixel);
+            open = send_message(descriptor, &reply, sizeof(reply), request.pixels.data(), outputs);
+        }
+        record(request.arrival);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        --receiving;
+    }
+    queued.notify_one(); // The batch may no longer have anyone to wait for
+    shutdown(descriptor, SHUT_RDWR); // The client sees end of stream now; the acceptor closes the descriptor when it reaps
+    connection.closed.store(true, std::memory_order_release);
+}
+
+void InferenceServer::worker_loop(int worker) {
+    Workspace& workspace = workspaces[worker];
+    std::vector<Request*> batch;
+    std::vector<const float*> inputs;
+    std::vector<float*> outputs;
+    batch.reserve(options.max_batch);
+    inputs.reserve(options.max_batch);
+    outputs.reserve(options.max_batch);
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            // Run once the batch is full, its oldest request reaches the
+            // deadline or no connection is left that could add to it; when
+            // stopping, drain what is left without waiting
+            for (;;) {
+                if (queue.empty()) {
+                    if (stopping) {
+                        return;
+                    }
+                    queued.wait(lock);
+                    continue;
+                }
+                const auto deadline = queue.front()->arrival + options.max_delay;
+                if (queue.size() >= static_cast<std::size_t>(options.max_batch) || receiving == 0 || stopping ||
+                    std::chrono::steady_clock::now() >= deadline) {
+                    break;
+                }
+                queued.wait_until(lock, deadline);
+            }
+            const std::size_t count = std::min(queue.size(), static_cast<std::size_t>(options.max_batch));
+            batch.assign(queue.begin(), queue.begin() + count);
+            queue.erase(queue.begin(), queue.begin() + count);
+            if (!queue.empty()) {
+                queued.notify_one(); // Another worker can start on the rest
+            }
+        }
+
+        inputs.clear();
+        outputs.clear();
+        for (Request* request : batch) {
+            inputs.push_back(request->input.data());
+            outputs.push_back(request->output.data());
+        }
+        model.predict_rows(inputs, outputs, workspace);
+
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            ++batches;
+        }
+        // Notify under the lock: once a reader sees done it may reuse or free its request
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Request* request : batch) {
+            request->done = true;
+            request->finished.notify_one();
+        }
+    }
+}
+
+void InferenceServer::record(std::chrono::steady_clock::time_point arrival) {
+    const float micros = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - arrival).count();
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    latencies[requests % kLatencyWindow] = micros;
+    ++requests;
+}
+
+InferenceClient::InferenceClient(const std::string& socket_path) {
+    const sockaddr_un address = socket_address(socket_path);
+    descriptor = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (descriptor < 0 || connect(descriptor, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        const std::string reason = std::strerror(errno);
+        if (descriptor >= 0) {
+            close(descriptor);
+        }
+        throw std::runtime_error("Could not connect to " + socket_path + ": " + reason);
+    }
+    if (!receive_all(descriptor, &hello, sizeof(hello)) || hello.magic != kServerMagic) {
+        close(descriptor);
+        throw std::runtime_error("No inference server at " + socket_path + ".");
+    }
+}
+
+InferenceClient::~InferenceClient() {
+    close(descriptor);
+}
+
+void InferenceClient::predict(std::span<const float> input, std::span<float> output) {
+    exchange(SampleFormat::F32, input.data(), input.size(), output.data(), output.size(), sizeof(float));
+}
+
+void InferenceClient::predict(std::span<const std::uint8_t> input, std::span<std::uint8_t> output) {
+    exchange(SampleFormat::U8, input.data(), input.size(), output.data(), output.size(), 1);
+}
+
+void InferenceClient::exchange(SampleFormat format, const void* input, std::size_t input_count, void* output,
+                               std::size_t output_count, std::size_t element_bytes) {
+    if (input_count != hello.input_size || output_count != hello.output_size) {
+        throw std::invalid_argument("Sample sizes do not match the served model.");
+    }
+    const RequestHeader request = {kRequestMagic, static_cast<std::uint32_t>(format), hello.input_size, 0};
+    ResponseHeader reply;
+    if (!send_message(descriptor, &request, sizeof(request), input, input_count * element_bytes) ||
+        !receive_all(descriptor, &reply, sizeof(reply)) || reply.magic != kResponseMagic) {
+        throw std::runtime_error("The inference server closed the connection.");
+    }
+    if (reply.status != static_cast<std::uint32_t>(ResponseStatus::Ok) || reply.count != output_count) {
+        throw std::runtime_error("The inference server rejected the request.");
+    }
+    if (!receive_all(descriptor, output, output_count * element_bytes)) {
+        throw std::runtime_error("The inference server closed the connection.");
+    }
+}
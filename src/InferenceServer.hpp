@@ -0,0 +1,179 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Layer.hpp"
+#include "Workspace.hpp"
+
+class MLP;
+class ThreadPool;
+
+// Wire protocol over a Unix stream socket, native byte order. On connect the
+// server sends a ServerHello; then each request is a RequestHeader followed
+// by one sample, answered by a ResponseHeader and the reconstruction in the
+// request's format. A connection carries one request at a time; clients open
+// several connections for concurrency.
+constexpr std::uint32_t kServerMagic = 0x48504c4d;   // "MLPH" in little-endian memory
+constexpr std::uint32_t kRequestMagic = 0x51504c4d;  // "MLPQ"
+constexpr std::uint32_t kResponseMagic = 0x52504c4d; // "MLPR"
+
+// Raw floats are received straight into the request buffer; 8-bit pixels map
+// to [0, 1] and the reply rounds back to 0..255
+enum class SampleFormat : std::uint32_t { F32 = 0, U8 = 1 };
+enum class ResponseStatus : std::uint32_t { Ok = 0, BadRequest = 1 };
+
+struct ServerHello {
+  std::uint32_t magic;
+  std::uint32_t input_size;
+  std::uint32_t output_size;
+  std::uint32_t max_batch;
+};
+
+struct RequestHeader {
+  std::uint32_t magic;
+  std::uint32_t format; // SampleFormat
+  std::uint32_t count;  // Elements that follow; must be the model input size
+  std::uint32_t reserved;
+};
+
+struct ResponseHeader {
+  std::uint32_t magic;
+  std::uint32_t status; // ResponseStatus; the server closes the connection after a bad request
+  std::uint32_t count;  // Elements that follow
+  std::uint32_t reserved;
+};
+
+static_assert(sizeof(ServerHello) == 16 && sizeof(RequestHeader) == 16 && sizeof(ResponseHeader) == 16,
+              "Protocol structs must not change size");
+
+struct ServerOptions {
+  std::string socket_path = "/tmp/mlp.sock";
+  int max_batch = 32; // Requests coalesced into one forward pass
+  // Longest the oldest queued request waits for its batch to fill
+  std::chrono::microseconds max_delay{500};
+  int workers = 1; // Inference threads, each with its own workspace; 0 uses every hardware thread
+};
+
+struct ServerStats {
+  std::uint64_t requests = 0;
+  std::uint64_t batches = 0;
+  std::uint64_t rejected = 0; // Bad requests
+  double seconds = 0.0;       // Since start
+  double requests_per_second = 0.0;
+  double mean_batch = 0.0;
+  // Receive to send, over the most recent kLatencyWindow requests
+  double p50_us = 0.0;
+  double p99_us = 0.0;
+};
+
+// The q-quantile of samples, which it reorders; 0 when empty
+double latency_percentile(std::vector<float> &samples, double q);
+
+// Serves one model over a Unix domain socket. Every connection has a reader
+// thread that receives requests into its own aligned buffers; a deadline
+// batcher hands up to max_batch queued requests at a time to the worker
+// pool, which runs them as one predict_rows call and wakes their readers to
+// send the replies.
+class InferenceServer {
+public:
+  static constexpr std::size_t kLatencyWindow = 1 << 16;
+
+  // The model must outlive the server; predictions only read it
+  InferenceServer(const MLP &model, ServerOptions options);
+  ~InferenceServer(); // Stops the server
+  InferenceServer(const InferenceServer &) = delete;
+  InferenceServer &operator=(const InferenceServer &) = delete;
+
+  // Binds the socket, replacing a stale file at its path, and returns once
+  // it accepts connections; throws std::runtime_error
+  void start();
+  // Stops accepting, closes every connection after its queued request is
+  // answered and joins all threads
+  void stop();
+  ServerStats stats() const;
+
+private:
+  struct Request {
+    AlignedVector<float> input;
+    AlignedVector<float> output;
+    std::vector<std::uint8_t> pixels; // U8 payloads on their way in and out
+    std::chrono::steady_clock::time_point arrival;
+    bool done = false; // Guarded by the queue mutex
+    std::condition_variable finished;
+  };
+  struct Connection {
+    int descriptor = -1;
+    std::thread reader;
+    std::atomic<bool> closed{false};
+    Request request;
+  };
+
+  void accept_loop();
+  // Joins the readers of closed connections and frees them; called by the
+  // acceptor on every wake, so a finished reader waits at most one reap interval
+  void reap_connections();
+  void serve(Connection &connection);
+  void worker_loop(int worker);
+  void record(std::chrono::steady_clock::time_point arrival);
+
+  const MLP &model;
+  ServerOptions options;
+  int listener = -1;
+  std::thread acceptor;
+  std::thread dispatcher; // Runs the worker pool; it takes part as worker 0
+  std::unique_ptr<ThreadPool> pool;
+  std::vector<Workspace> workspaces;
+
+  std::mutex connections_mutex;
+  std::list<Connection> connections; // Nodes stay put while their reader runs
+
+  std::mutex mutex; // Queue, request completion and stopping
+  std::condition_variable queued;
+  std::deque<Request *> queue;
+  int receiving = 0; // Connections without a request queued or in flight
+  bool stopping = false;
+
+  mutable std::mutex stats_mutex;
+  std::chrono::steady_clock::time_point started;
+  std::vector<float> latencies; // Microseconds, ring of kLatencyWindow
+  std::uint64_t requests = 0;
+  std::uint64_t batches = 0;
+  std::uint64_t rejected = 0;
+};
+
+// Blocking client for one connection to an InferenceServer
+class InferenceClient {
+public:
+  // Connects and reads the server's model sizes; throws std::runtime_error
+  explicit InferenceClient(const std::string &socket_path);
+  ~InferenceClient();
+  InferenceClient(const InferenceClient &) = delete;
+  InferenceClient &operator=(const InferenceClient &) = delete;
+
+  // One sample in, its reconstruction out; sizes must match the model.
+  // Throws std::runtime_error when the server rejects or drops the request.
+  void predict(std::span<const float> input, std::span<float> output);
+  void predict(std::span<const std::uint8_t> input, std::span<std::uint8_t> output);
+
+  int input_size() const { return static_cast<int>(hello.input_size); }
+  int output_size() const { return static_cast<int>(hello.output_size); }
+  int max_batch() const { return static_cast<int>(hello.max_batch); }
+
+private:
+  void exchange(SampleFormat format, const void *input, std::size_t input_count, void *output,
+                std::size_t output_count, std::size_t element_bytes);
+
+  int descriptor = -1;
+  ServerHello hello{};
+};
@@ -0,0 +1,1033 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MLP_KERNELS_X86 1
+#define TARGET_AVX2 __attribute__((target("avx2,fma,f16c")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#define TARGET_AVX512VNNI __attribute__((target("avx512f,avx512vnni")))
+#endif
+
+// Kernels.cpp
+#include "Kernels.hpp"
+
+namespace kernels {
+namespace {
+
+struct Table {
+    Isa isa;
+    float (*dot)(const float*, const float*, std::size_t);
+    void (*dot_rows)(const float*, std::size_t, const float*, std::size_t, std::size_t, float*);
+    void (*axpy)(float, const float*, float*, std::size_t);
+    void (*bias_sigmoid)(float*, const float*, std::size_t);
+    void (*momentum_update)(float*, const float*, float*, std::size_t, const UpdateStep&);
+    void (*adam_update)(float*, const float*, float*, float*, std::size_t, const UpdateStep&);
+    std::int32_t (*dot_u8s8)(const std::uint8_t*, const std::int8_t*, std::size_t);
+    float (*dot_bf16)(const float*, const std::uint16_t*, std::size_t);
+    float (*dot_f16)(const float*, const std::uint16_t*, std::size_t);
+    void (*block_sparse_multiply)(const BlockSparseMatrix&, const float*, std::size_t, float*, std::size_t, std::size_t);
+    MicroKernel micro_kernel;
+};
+
+// Portable reference path, kept identical to the original scalar loops
+
+float scalar_dot(const float* a, const float* b, std::size_t n) {
+    float result = 0.0f;
+    for (std::size_t i = 0; i < n; ++i) {
+        result += a[i] * b[i];
+    }
+    return result;
+}
+
+void scalar_dot_rows(const float* a, std::size_t lda, const float* x, std::size_t n, std::size_t rows, float* out) {
+    for (std::size_t r = 0; r < rows; ++r) {
+        out[r] = scalar_dot(a + r * lda, x, n);
+    }
+}
+
+void scalar_axpy(float alpha, const float* x, float* y, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        y[i] += alpha * x[i];
+    }
+}
+
+void scalar_bias_sigmoid(float* x, const float* bias, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = 1.0f / (1.0f + std::exp(-(x[i] + bias[i])));
+    }
+}
+
+void scalar_momentum_update(float* w, const float* g, float* v, std::size_t n, const UpdateStep& step) {
+    for (std::size_t i = 0; i < n; ++i) {
+        v[i] = step.beta1 * v[i] + step.grad_scale * g[i];
+        w[i] -= step.rate * v[i];
+    }
+}
+
+void scalar_adam_update(float* w, const float* g, float* m, float* v, std::size_t n, const UpdateStep& step) {
+    for (std::size_t i = 0; i < n; ++i) {
+        const float gradient = step.grad_scale * g[i];
+        m[i] = step.beta1 * m[i] + (1.0f - step.beta1) * gradient;
+        v[i] = step.beta2 * v[i] + (1.0f - step.beta2) * gradient * gradient;
+        w[i] -= step.rate * m[i] / (std::sqrt(v[i]) + step.epsilon);
+    }
+}
+
+std::int32_t scalar_dot_u8s8(const std::uint8_t* a, const std::int8_t* b, std::size_t n) {
+    std::int32_t result = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        result += a[i] * b[i];
+    }
+    return result;
+}
+
+float scalar_dot_bf16(const float* a, const std::uint16_t* b, std::size_t n) {
+    float result = 0.0f;
+    for (std::size_t i = 0; i < n; ++i) {
+        result += a[i] * bf16_to_float(b[i]);
+    }
+    return result;
+}
+
+float scalar_dot_f16(const float* a, const std::uint16_t* b, std::size_t n) {
+    float result = 0.0f;
+    for (std::size_t i = 0; i < n; ++i) {
+        result += a[i] * f16_to_float(b[i]);
+    }
+    return result;
+}
+
+void scalar_block_sparse_multiply(const BlockSparseMatrix& a, const float* x, std::size_t ldx, float* y,
+                                  std::size_t ldy, std::size_t count) {
+    const int row_blocks = (a.rows + a.block_rows - 1) / a.block_rows;
+    const std::size_t block_size = static_cast<std::size_t>(a.block_rows) * a.block_cols;
+    for (std::size_t b = 0; b < count; ++b) {
+        const float* xb = x + b * ldx;
+        float* yb = y + b * ldy;
+        for (int i = 0; i < row_blocks; ++i) {
+            const int valid = std::min(a.block_rows, a.rows - i * a.block_rows);
+            for (int r = 0; r < valid; ++r) {
+                float sum = 0.0f;
+                for (std::int32_t k = a.row_offsets[i]; k < a.row_offsets[i + 1]; ++k) {
+                    const float* values = a.values + k * block_size + r * a.block_cols;
+                    const float* xk = xb + a.columns[k];
+                    for (int c = 0; c < a.block_cols; ++c) {
+                        sum += values[c] * xk[c];
+                    }
+                }
+                yb[i * a.block_rows + r] = sum;
+            }
+        }
+    }
+}
+
+// 4x8 tile: eight accumulator registers even with SSE2, and GCC vectorizes it unaided
+constexpr int kScalarMR = 4;
+constexpr int kScalarNR = 8;
+
+void scalar_micro_kernel(int depth, const float* a, const float* b, float* out) {
+    float acc[kScalarMR][kScalarNR] = {};
+    for (int p = 0; p < depth; ++p) {
+        for (int i = 0; i < kScalarMR; ++i) {
+            const float a_value = a[i];
+            for (int j = 0; j < kScalarNR; ++j) {
+                acc[i][j] += a_value * b[j];
+            }
+        }
+        a += kScalarMR;
+        b += kScalarNR;
+    }
+    std::memcpy(out, acc, sizeof(acc));
+}
+
+const Table scalar_table = {Isa::Scalar, scalar_dot, scalar_dot_rows, scalar_axpy, scalar_bias_sigmoid,
+                            scalar_momentum_update, scalar_adam_update,
+                            scalar_dot_u8s8, scalar_dot_bf16, scalar_dot_f16, scalar_block_sparse_multiply,
+                            {kScalarMR, kScalarNR, scalar_micro_kernel}};
+
+#ifdef MLP_KERNELS_X86
+
+// GCC flags the deliberately undefined registers inside its AVX-512 intrinsic headers
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// AVX2 + FMA: 8 floats per register
+
+TARGET_AVX2 inline float avx2_sum(__m256 v) {
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+    return _mm_cvtss_f32(sum);
+}
+
+TARGET_AVX2 inline __m256 avx2_exp(__m256 x) {
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(kExpLow)), _mm256_set1_ps(kExpHigh));
+    const __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(kLog2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(kLn2High), x);
+    r = _mm256_fnmadd_ps(n, _mm256_set1_ps(kLn2Low), r);
+    __m256 p = _mm256_set1_ps(kExpPoly[0]);
+    for (int i = 1; i < 6; ++i) {
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kExpPoly[i]));
+    }
+    p = _mm256_fmadd_ps(p, _mm256_mul_ps(r, r), _mm256_add_ps(r, _mm256_set1_ps(1.0f)));
+    const __m256i exponent = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(p, _mm256_castsi256_ps(exponent));
+}
+
+TARGET_AVX2 float avx2_dot(const float* a, const float* b, std::size_t n) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps();
+    __m256 acc3 = _mm256_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) { // Four independent chains hide the FMA latency
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+        acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), acc2);
+        acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), acc3);
+    }
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    }
+    float result = avx2_sum(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+    for (; i < n; ++i) {
+        result += a[i] * b[i];
+    }
+    return result;
+}
+
+// Four rows per pass share every load of x
+TARGET_AVX2 void avx2_dot_rows(const float* a, std::size_t lda, const float* x, std::size_t n, std::size_t rows, float* out) {
+    std::size_t r = 0;
+    for (; r + 4 <= rows; r += 4) {
+        const float* a0 = a + r * lda;
+        const float* a1 = a0 + lda;
+        const float* a2 = a1 + lda;
+        const float* a3 = a2 + lda;
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps();
+        __m256 acc3 = _mm256_setzero_ps();
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            const __m256 xi = _mm256_loadu_ps(x + i);
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a0 + i), xi, acc0);
+            acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a1 + i), xi, acc1);
+            acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(a2 + i), xi, acc2);
+            acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(a3 + i), xi, acc3);
+        }
+        out[r] = avx2_sum(acc0);
+        out[r + 1] = avx2_sum(acc1);
+        out[r + 2] = avx2_sum(acc2);
+        out[r + 3] = avx2_sum(acc3);
+        for (; i < n; ++i) {
+            out[r] += a0[i] * x[i];
+            out[r + 1] += a1[i] * x[i];
+            out[r + 2] += a2[i] * x[i];
+            out[r + 3] += a3[i] * x[i];
+        }
+    }
+    for (; r < rows; ++r) {
+        out[r] = avx2_dot(a + r * lda, x, n);
+    }
+}
+
+TARGET_AVX2 void avx2_axpy(float alpha, const float* x, float* y, std::size_t n) {
+    const __m256 scale = _mm256_set1_ps(alpha);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(y + i, _mm256_fmadd_ps(scale, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+    }
+    for (; i < n; ++i) {
+        y[i] += alpha * x[i];
+    }
+}
+
+TARGET_AVX2 void avx2_bias_sigmoid(float* x, const float* bias, std::size_t n) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 z = _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(bias + i));
+        const __m256 e = avx2_exp(_mm256_sub_ps(_mm256_setzero_ps(), z));
+        _mm256_storeu_ps(x + i, _mm256_div_ps(one, _mm256_add_ps(one, e)));
+    }
+    if (i < n) { // Run the tail through a zero-padded register for identical rounding
+        float tail_x[8] = {};
+        float tail_bias[8] = {};
+        std::memcpy(tail_x, x + i, (n - i) * sizeof(float));
+        std::memcpy(tail_bias, bias + i, (n - i) * sizeof(float));
+        avx2_bias_sigmoid(tail_x, tail_bias, 8);
+        std::memcpy(x + i, tail_x, (n - i) * sizeof(float));
+    }
+}
+
+TARGET_AVX2 void avx2_momentum_update(float* w, const float* g, float* v, std::size_t n, const UpdateStep& step) {
+    const __m256 scale = _mm256_set1_ps(step.grad_scale);
+    const __m256 beta = _mm256_set1_ps(step.beta1);
+    const __m256 rate = _mm256_set1_ps(step.rate);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 velocity = _mm256_fmadd_ps(beta, _mm256_loadu_ps(v + i), _mm256_mul_ps(scale, _mm256_loadu_ps(g + i)));
+        _mm256_storeu_ps(v + i, velocity);
+        _mm256_storeu_ps(w + i, _mm256_fnmadd_ps(rate, velocity, _mm256_loadu_ps(w + i)));
+    }
+    for (; i < n; ++i) {
+        v[i] = step.beta1 * v[i] + step.grad_scale * g[i];
+        w[i] -= step.rate * v[i];
+    }
+}
+
+TARGET_AVX2 void avx2_adam_update(float* w, const float* g, float* m, float* v, std::size_t n, const UpdateStep& step) {
+    const __m256 scale = _mm256_set1_ps(step.grad_scale);
+    const __m256 beta1 = _mm256_set1_ps(step.beta1);
+    const __m256 beta2 = _mm256_set1_ps(step.beta2);
+    const __m256 rest1 = _mm256_set1_ps(1.0f - step.beta1);
+    const __m256 rest2 = _mm256_set1_ps(1.0f - step.beta2);
+    const __m256 rate = _mm256_set1_ps(step.rate);
+    const __m256 epsilon = _mm256_set1_ps(step.epsilon);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 gradient = _mm256_mul_ps(scale, _mm256_loadu_ps(g + i));
+        const __m256 first = _mm256_fmadd_ps(beta1, _mm256_loadu_ps(m + i), _mm256_mul_ps(rest1, gradient));
+        const __m256 second = _mm256_fmadd_ps(beta2, _mm256_loadu_ps(v + i), _mm256_mul_ps(rest2, _mm256_mul_ps(gradient, gradient)));
+        _mm256_storeu_ps(m + i, first);
+        _mm256_storeu_ps(v + i, second);
+        const __m256 denominator = _mm256_add_ps(_mm256_sqrt_ps(second), epsilon);
+        _mm256_storeu_ps(w + i, _mm256_fnmadd_ps(rate, _mm256_div_ps(first, denominator), _mm256_loadu_ps(w + i)));
+    }
+    if (i < n) { // Same zero-padded tail as bias_sigmoid, so every element rounds alike
+        float tail_w[8] = {}, tail_g[8] = {}, tail_m[8] = {}, tail_v[8] = {};
+        const std::size_t bytes = (n - i) * sizeof(float);
+        std::memcpy(tail_w, w + i, bytes);
+        std::memcpy(tail_g, g + i, bytes);
+        std::memcpy(tail_m, m + i, bytes);
+        std::memcpy(tail_v, v + i, bytes);
+        avx2_adam_update(tail_w, tail_g, tail_m, tail_v, 8, step);
+        std::memcpy(w + i, tail_w, bytes);
+        std::memcpy(m + i, tail_m, bytes);
+        std::memcpy(v + i, tail_v, bytes);
+    }
+}
+
+// u8 x s8 pairs summed into int16 by maddubs, then widened to int32 by madd
+TARGET_AVX2 std::int32_t avx2_dot_u8s8(const std::uint8_t* a, const std::int8_t* b, std::size_t n) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    for (std::size_t i = 0; i < n; i += 64) {
+        const __m256i pairs0 = _mm256_maddubs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                                                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+        const __m256i pairs1 = _mm256_maddubs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i + 32)),
+                                                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i + 32)));
+        acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(pairs0, ones));
+        acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(pairs1, ones));
+    }
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(_mm256_add_epi32(acc0, acc1)),
+                                _mm256_extracti128_si256(_mm256_add_epi32(acc0, acc1), 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+
+// bf16 is the top half of an fp32, so widening is a zero extend and a shift
+TARGET_AVX2 float avx2_dot_bf16(const float* a, const std::uint16_t* b, std::size_t n) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256i packed = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        const __m256 low = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(packed)), 16));
+        const __m256 high = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(packed, 1)), 16));
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), low, acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), high, acc1);
+    }
+    float result = avx2_sum(_mm256_add_ps(acc0, acc1));
+    for (; i < n; ++i) {
+        result += a[i] * bf16_to_float(b[i]);
+    }
+    return result;
+}
+
+TARGET_AVX2 float avx2_dot_f16(const float* a, const std::uint16_t* b, std::size_t n) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256 low = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+        const __m256 high = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i + 8)));
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), low, acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), high, acc1);
+    }
+    float result = avx2_sum(_mm256_add_ps(acc0, acc1));
+    for (; i < n; ++i) {
+        result += a[i] * f16_to_float(b[i]);
+    }
+    return result;
+}
+
+// CSR: eight gathered x values per FMA, two chains
+TARGET_AVX2 void avx2_csr_multiply(const BlockSparseMatrix& a, const float* x, std::size_t ldx, float* y,
+                                   std::size_t ldy, std::size_t count) {
+    for (int i = 0; i < a.rows; ++i) {
+        const std::int32_t first = a.row_offsets[i];
+        const std::int32_t last = a.row_offsets[i + 1];
+        for (std::size_t b = 0; b < count; ++b) {
+            const float* xb = x + b * ldx;
+            __m256 acc0 = _mm256_setzero_ps();
+            __m256 acc1 = _mm256_setzero_ps();
+            std::int32_t k = first;
+            for (; k + 16 <= last; k += 16) {
+                const __m256i index0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.columns + k));
+                const __m256i index1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.columns + k + 8));
+                acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a.values + k), _mm256_i32gather_ps(xb, index0, 4), acc0);
+                acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a.values + k + 8), _mm256_i32gather_ps(xb, index1, 4), acc1);
+            }
+            for (; k + 8 <= last; k += 8) {
+                const __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.columns + k));
+                acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a.values + k), _mm256_i32gather_ps(xb, index, 4), acc0);
+            }
+            float sum = avx2_sum(_mm256_add_ps(acc0, acc1));
+            for (; k < last; ++k) {
+                sum += a.values[k] * xb[a.columns[k]];
+            }
+            y[b * ldy + i] = sum;
+        }
+    }
+}
+
+template <int Rows, int Cols>
+TARGET_AVX2 inline void avx2_block_fma(const float* block, const float* x, __m256* acc) {
+    for (int v = 0; v < Cols; v += 8) {
+        const __m256 xv = _mm256_loadu_ps(x + v);
+        for (int r = 0; r < Rows; ++r) {
+            acc[r] = _mm256_fmadd_ps(_mm256_loadu_ps(block + r * Cols + v), xv, acc[r]);
+        }
+    }
+}
+
+// Rows x Cols blocks: one accumulator per block row, or two chains when
+// there are too few rows to hide the FMA latency
+template <int Rows, int Cols>
+TARGET_AVX2 void avx2_block_multiply(const BlockSparseMatrix& a, const float* x, std::size_t ldx, float* y,
+                                     std::size_t ldy, std::size_t count) {
+    constexpr int chains = Rows >= 4 ? 1 : 2;
+    constexpr int block_size = Rows * Cols;
+    const int row_blocks = (a.rows + Rows - 1) / Rows;
+    for (int i = 0; i < row_blocks; ++i) {
+        const std::int32_t first = a.row_offsets[i];
+        const std::int32_t last = a.row_offsets[i + 1];
+        const int valid = std::min(Rows, a.rows - i * Rows);
+        for (std::size_t b = 0; b < count; ++b) {
+            const float* xb = x + b * ldx;
+            __m256 acc[chains][Rows];
+            for (int c = 0; c < chains; ++c) {
+                for (int r = 0; r < Rows; ++r) {
+                    acc[c][r] = _mm256_setzero_ps();
+                }
+            }
+            std::int32_t k = first;
+            if constexpr (chains == 2) {
+                for (; k + 2 <= last; k += 2) {
+                    avx2_block_fma<Rows, Cols>(a.values + static_cast<std::size_t>(k) * block_size, xb + a.columns[k], acc[0]);
+                    avx2_block_fma<Rows, Cols>(a.values + static_cast<std::size_t>(k + 1) * block_size, xb + a.columns[k + 1], acc[1]);
+                }
+            }
+            for (; k < last; ++k) {
+                avx2_block_fma<Rows, Cols>(a.values + static_cast<std::size_t>(k) * block_size, xb + a.columns[k], acc[0]);
+            }
+            float* yb = y + b * ldy + i * Rows;
+            for (int r = 0; r < valid; ++r) {
+                __m256 sum = acc[0][r];
+                if constexpr (chains == 2) {
+                    sum = _mm256_add_ps(sum, acc[1][r]);
+                }
+                yb[r] = avx2_sum(sum);
+            }
+        }
+    }
+}
+
+// Eight-column blocks, shared with the AVX-512 table
+TARGET_AVX2 bool avx2_block_multiply_8(const BlockSparseMatrix& a, const float* x, std::size_t ldx, float* y,
+                                       std::size_t ldy, std::size_t count) {
+    switch (a.block_rows) {
+    case 1:
+        avx2_block_multiply<1, 8>(a, x, ldx, y, ldy, count);
+        return true;
+    case 2:
+        avx2_block_multiply<2, 8>(a, x, ldx, y, ldy, count);
+        return true;
+    case 4:
+        avx2_block_multiply<4, 8>(a, x, ldx, y, ldy, count);
+        return true;
+    case 8:
+        avx2_block_multiply<8, 8>(a, x, ldx, y, ldy, count);
+        return true;
+    }
+    return false;
+}
+
+TARGET_AVX2 void avx2_block_sparse_multiply(const BlockSparseMatrix& a, const float* x, std::size_t ldx, float* y,
+                                            std::size_t ldy, std::size_t count) {
+    if (a.block_rows == 1 && a.block_cols == 1) {
+        avx2_csr_multiply(a, x, ldx, y, ldy, count);
+        return;
+    }
+    if (a.block_cols == 8 && avx2_block_multiply_8(a, x, ldx, y, ldy, count)) {
+        return;
+    }
+    if (a.block_cols == 16) {
+        switch (a.block_rows) {
+        case 1:
+            avx2_block_multiply<1, 16>(a, x, ldx, y, ldy, count);
+            return;
+        case 2:
+            avx2_block_multiply<2, 16>(a, x, ldx, y, ldy, count);
+            return;
+        case 4:
+            avx2_block_multiply<4, 16>(a, x, ldx, y, ldy, count);
+            return;
+        case 8:
+            avx2_block_multiply<8, 16>(a, x, ldx, y, ldy, count);
+            return;
+        }
+    }
+    scalar_block_sparse_multiply(a, x, ldx, y, ldy, count);
+}
+
+// 6x16 tile: twelve accumulators, two B vectors and one broadcast fit in 16 ymm registers
+constexpr int kAvx2MR = 6;
+constexpr int kAvx2NR = 16;
+
+TARGET_AVX2 void avx2_micro_kernel(int depth, const float* a, const float* b, float* out) {
+    __m256 acc[kAvx2MR][2];
+    for (int i = 0; i < kAvx2MR; ++i) {
+        acc[i][0] = _mm256_setzero_ps();
+        acc[i][1] = _mm256_setzero_ps();
+    }
+    for (int p = 0; p < depth; ++p) {
+        const __m256 b0 = _mm256_loadu_ps(b);
+        const __m256 b1 = _mm256_loadu_ps(b + 8);
+        for (int i = 0; i < kAvx2MR; ++i) {
+            const __m256 a_value = _mm256_broadcast_ss(a + i);
+            acc[i][0] = _mm256_fmadd_ps(a_value, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_ps(a_value, b1, acc[i][1]);
+        }
+        a += kAvx2MR;
+        b += kAvx2NR;
+    }
+    for (int i = 0; i < kAvx2MR; ++i) {
+        _mm256_storeu_ps(out + i * kAvx2NR, acc[i][0]);
+        _mm256_storeu_ps(out + i * kAvx2NR + 8, acc[i][1]);
+    }
+}
+
+const Table avx2_table = {Isa::AVX2, avx2_dot, avx2_dot_rows, avx2_axpy, avx2_bias_sigmoid,
+                          avx2_momentum_update, avx2_adam_update,
+                          avx2_dot_u8s8, avx2_dot_bf16, avx2_dot_f16, avx2_block_sparse_multiply,
+                          {kAvx2MR, kAvx2NR, avx2_micro_kernel}};
+
+// AVX-512: 16 floats per register, tails handled with masked loads
+
+TARGET_AVX512 inline __mmask16 avx512_tail_mask(std::size_t remaining) {
+    return static_cast<__mmask16>((1u << remaining) - 1);
+}
+
+TARGET_AVX512 inline __m512 avx512_exp(__m512 x) {
+    x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(kExpLow)), _mm512_set1_ps(kExpHigh));
+    const __m512 n = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(kLog2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512 r = _mm512_fnmadd_ps(n, _mm512_set1_ps(kLn2High), x);
+    r = _mm512_fnmadd_ps(n, _mm512_set1_ps(kLn2Low), r);
+    __m512 p = _mm512_set1_ps(kExpPoly[0]);
+    for (int i = 1; i < 6; ++i) {
+        p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kExpPoly[i]));
+    }
+    p = _mm512_fmadd_ps(p, _mm512_mul_ps(r, r), _mm512_add_ps(r, _mm512_set1_ps(1.0f)));
+    const __m512i exponent = _mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127)), 23);
+    return _mm512_mul_ps(p, _mm512_castsi512_ps(exponent));
+}
+
+TARGET_AVX512 float avx512_dot(const float* a, const float* b, std::size_t n) {
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    __m512 acc2 = _mm512_setzero_ps();
+    __m512 acc3 = _mm512_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), acc1);
+        acc2 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 32), _mm512_loadu_ps(b + i + 32), acc2);
+        acc3 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 48), _mm512_loadu_ps(b + i + 48), acc3);
+    }
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+    }
+    if (i < n) {
+        const __mmask16 mask = avx512_tail_mask(n - i);
+        acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i), acc1);
+    }
+    return _mm512_reduce_add_ps(_mm512_add_ps(_mm512_add_ps(acc0, acc1), _mm512_add_ps(acc2, acc3)));
+}
+
+TARGET_AVX512 void avx512_dot_rows(const float* a, std::size_t lda, const float* x, std::size_t n, std::size_t rows, float* out) {
+    std::size_t r = 0;
+    for (; r + 4 <= rows; r += 4) {
+        const float* a0 = a + r * lda;
+        const float* a1 = a0 + lda;
+        const float* a2 = a1 + lda;
+        const float* a3 = a2 + lda;
+        __m512 acc0 = _mm512_setzero_ps();
+        __m512 acc1 = _mm512_setzero_ps();
+        __m512 acc2 = _mm512_setzero_ps();
+        __m512 acc3 = _mm512_setzero_ps();
+        std::size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const __m512 xi = _mm512_loadu_ps(x + i);
+            acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a0 + i), xi, acc0);
+            acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a1 + i), xi, acc1);
+            acc2 = _mm512_fmadd_ps(_mm512_loadu_ps(a2 + i), xi, acc2);
+            acc3 = _mm512_fmadd_ps(_mm512_loadu_ps(a3 + i), xi, acc3);
+        }
+        if (i < n) {
+            const __mmask16 mask = avx512_tail_mask(n - i);
+            const __m512 xi = _mm512_maskz_loadu_ps(mask, x + i);
+            acc0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a0 + i), xi, acc0);
+            acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a1 + i), xi, acc1);
+            acc2 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a2 + i), xi, acc2);
+            acc3 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a3 + i), xi, acc3);
+        }
+        out[r] = _mm512_reduce_add_ps(acc0);
+        out[r + 1] = _mm512_reduce_add_ps(acc1);
+        out[r + 2] = _mm512_reduce_add_ps(acc2);
+        out[r + 3] = _mm512_reduce_add_ps(acc3);
+    }
+    for (; r < rows; ++r) {
+        out[r] = avx512_dot(a + r * lda, x, n);
+    }
+}
+
+TARGET_AVX512 void avx512_axpy(float alpha, const float* x, float* y, std::size_t n) {
+    const __m512 scale = _mm512_set1_ps(alpha);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(y + i, _mm512_fmadd_ps(scale, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+    }
+    if (i < n) {
+        const __mmask16 mask = avx512_tail_mask(n - i);
+        const __m512 result = _mm512_fmadd_ps(scale, _mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i));
+        _mm512_mask_storeu_ps(y + i, mask, result);
+    }
+}
+
+TARGET_AVX512 void avx512_bias_sigmoid(float* x, const float* bias, std::size_t n) {
+    const __m512 one = _mm512_set1_ps(1.0f);
+    for (std::size_t i = 0; i < n; i += 16) {
+        const __mmask16 mask = n - i >= 16 ? static_cast<__mmask16>(0xFFFF) : avx512_tail_mask(n - i);
+        const __m512 z = _mm512_add_ps(_mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, bias + i));
+        const __m512 e = avx512_exp(_mm512_sub_ps(_mm512_setzero_ps(), z));
+        _mm512_mask_storeu_ps(x + i, mask, _mm512_div_ps(one, _mm512_add_ps(one, e)));
+    }
+}
+
+TARGET_AVX512 void avx512_momentum_update(float* w, const float* g, float* v, std::size_t n, const UpdateStep& step) {
+    const __m512 scale = _mm512_set1_ps(step.grad_scale);
+    const __m512 beta = _mm512_set1_ps(step.beta1);
+    const __m512 rate = _mm512_set1_ps(step.rate);
+    for (std::size_t i = 0; i < n; i += 16) {
+        const __mmask16 mask = n - i >= 16 ? static_cast<__mmask16>(0xFFFF) : avx512_tail_mask(n - i);
+        const __m512 velocity = _mm512_fmadd_ps(beta, _mm512_maskz_loadu_ps(mask, v + i),
+                                                _mm512_mul_ps(scale, _mm512_maskz_loadu_ps(mask, g + i)));
+        _mm512_mask_storeu_ps(v + i, mask, velocity);
+        _mm512_mask_storeu_ps(w + i, mask, _mm512_fnmadd_ps(rate, velocity, _mm512_maskz_loadu_ps(mask, w + i)));
+    }
+}
+
+TARGET_AVX512 void avx512_adam_update(float* w, const float* g, float* m, float* v, std::size_t n, const UpdateStep& step) {
+    const __m512 scale = _mm512_set1_ps(step.grad_scale);
+    const __m512 beta1 = _mm512_set1_ps(step.beta1);
+    const __m512 beta2 = _mm512_set1_ps(step.beta2);
+    const __m512 rest1 = _mm512_set1_ps(1.0f - step.beta1);
+    const __m512 rest2 = _mm512_set1_ps(1.0f - step.beta2);
+    const __m512 rate = _mm512_set1_ps(step.rate);
+    const __m512 epsilon = _mm512_set1_ps(step.epsilon);
+    for (std::size_t i = 0; i < n; i += 16) {
+        const __mmask16 mask = n - i >= 16 ? static_cast<__mmask16>(0xFFFF) : avx512_tail_mask(n - i);
+        const __m512 gradient = _mm512_mul_ps(scale, _mm512_maskz_loadu_ps(mask, g + i));
+        const __m512 first = _mm512_fmadd_ps(beta1, _mm512_maskz_loadu_ps(mask, m + i), _mm512_mul_ps(rest1, gradient));
+        const __m512 second = _mm512_fmadd_ps(beta2, _mm512_maskz_loadu_ps(mask, v + i),
+                                              _mm512_mul_ps(rest2, _mm512_mul_ps(gradient, gradient)));
+        _mm512_mask_storeu_ps(m + i, mask, first);
+        _mm512_mask_storeu_ps(v + i, mask, second);
+        const __m512 denominator = _mm512_add_ps(_mm512_sqrt_ps(second), epsilon);
+        _mm512_mask_storeu_ps(w + i, mask, _mm512_fnmadd_ps(rate, _mm512_div_ps(first, denominator), _mm512_maskz_loadu_ps(mask, w + i)));
+    }
+}
+
+TARGET_AVX512 float avx512_dot_bf16(const float* a, const std::uint16_t* b, std::size_t n) {
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m512i low = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+        const __m512i high = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i + 16)));
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_castsi512_ps(_mm512_slli_epi32(low, 16)), acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_castsi512_ps(_mm512_slli_epi32(high, 16)), acc1);
+    }
+    float result = _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+    for (; i < n; ++i) {
+        result += a[i] * bf16_to_float(b[i]);
+    }
+    return result;
+}
+
+TARGET_AVX512 float avx512_dot_f16(const float* a, const std::uint16_t* b, std::size_t n) {
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m512 low = _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+        const __m512 high = _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i + 16)));
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), low, acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), high, acc1);
+    }
+    float result = _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+    for (; i < n; ++i) {
+        result += a[i] * f16_to_float(b[i]);
+    }
+    return result;
+}
+
+// VNNI fuses the u8 x s8 multiply and the int32 accumulate into one instruction
+TARGET_AVX512VNNI std::int32_t avx512_vnni_dot_u8s8(const std::uint8_t* a, const std::int8_t* b, std::size_t n) {
+    __m512i acc = _mm512_setzero_si512();
+    for (std::size_t i = 0; i < n; i += 64) {
+        acc = _mm512_dpbusd_epi32(acc, _mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+    }
+    return _mm512_reduce_add_epi32(acc);
+}
+
+// CSR: sixteen gathered x values per FMA, the row tail under a mask
+TARGET_AVX512 void avx512_csr_multiply(const BlockSparseMatrix& a, const float* x, std::size_t ldx, float* y,
+                                       std::size_t ldy, std::size_t count) {
+    for (int i = 0; i < a.rows; ++i) {
+        const std::int32_t first = a.row_offsets[i];
+        const std::int32_t last = a.row_offsets[i + 1];
+        for (std::size_t b = 0; b < count; ++b) {
+            const float* xb = x + b * ldx;
+            __m512 acc0 = _mm512_setzero_ps();
+            __m512 acc1 = _mm512_setzero_ps();
+            std::int32_t k = first;
+            for (; k + 32 <= last; k += 32) {
+                const __m512i index0 = _mm512_loadu_si512(a.columns + k);
+                const __m512i index1 = _mm512_loadu_si512(a.columns + k + 16);
+                acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a.values + k), _mm512_i32gather_ps(index0, xb, 4), acc0);
+                acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a.values + k + 16), _mm512_i32gather_ps(index1, xb, 4), acc1);
+            }
+            for (; k + 16 <= last; k += 16) {
+                const __m512i index = _mm512_loadu_si512(a.columns + k);
+                acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a.values + k), _mm512_i32gather_ps(index, xb, 4), acc0);
+            }
+            if (k < last) {
+                const __mmask16 mask = avx512_tail_mask(static_cast<std::size_t>(last - k));
+                const __m512i index = _mm512_maskz_loadu_epi32(mask, a.columns + k);
+                const __m512 gathered = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), mask, index, xb, 4);
+                acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a.values + k), gathered, acc1);
+            }
+            y[b * ldy + i] = _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+        }
+    }
+}
+
+template <int Rows>
+TARGET_AVX512 inline void avx512_block_fma(const float* block, const float* x, __m512* acc) {
+    const __m512 xv = _mm512_loadu_ps(x);
+    for (int r = 0; r < Rows; ++r) {
+        acc[r] = _mm512_fmadd_ps(_mm512_loadu_ps(block + r * 16), xv, acc[r]);
+    }
+}
+
+// Rows x 16 blocks: a block row of the tile is one zmm register
+template <int Rows>
+TARGET_AVX512 void avx512_block_multiply(const BlockSparseMatrix& a, const float* x, std::size_t ldx, float* y,
+                                         std::size_t ldy, std::size_t count) {
+    constexpr int chains = Rows >= 4 ? 1 : 2;
+    constexpr int block_size = Rows * 16;
+    const int row_blocks = (a.rows + Rows - 1) / Rows;
+    for (int i = 0; i < row_blocks; ++i) {
+        const std::int32_t first = a.row_offsets[i];
+        const std::int32_t last = a.row_offsets[i + 1];
+        const int valid = std::min(Rows, a.rows - i * Rows);
+        for (std::size_t b = 0; b < count; ++b) {
+            const float* xb = x + b * ldx;
+            __m512 acc[chains][Rows];
+            for (int c = 0; c < chains; ++c) {
+                for (int r = 0; r < Rows; ++r) {
+                    acc[c][r] = _mm512_setzero_ps();
+                }
+            }
+            std::int32_t k = first;
+            if constexpr (chains == 2) {
+                for (; k + 2 <= last; k += 2) {
+                    avx512_block_fma<Rows>(a.values + static_cast<std::size_t>(k) * block_size, xb + a.columns[k], acc[0]);
+                    avx512_block_fma<Rows>(a.values + static_cast<std::size_t>(k + 1) * block_size, xb + a.columns[k + 1], acc[1]);
+                }
+            }
+            for (; k < last; ++k) {
+                avx512_block_fma<Rows>(a.values + static_cast<std::size_t>(k) * block_size, xb + a.columns[k], acc[0]);
+            }
+            float* yb = y + b * ldy + i * Rows;
+            for (int r = 0; r < valid; ++r) {
+                __m512 sum = acc[0][r];
+                if constexpr (chains == 2) {
+                    sum = _mm512_add_ps(sum, acc[1][r]);
+                }
+                yb[r] = _mm512_reduce_add_ps(sum);
+            }
+        }
+    }
+}
+
+TARGET_AVX512 void avx512_block_sparse_multiply(const BlockSparseMatrix& a, const float* x, std::size_t ldx, float* y,
+                                                std::size_t ldy, std::size_t count) {
+    if (a.block_rows == 1 && a.block_cols == 1) {
+        avx512_csr_multiply(a, x, ldx, y, ldy, count);
+        return;
+    }
+    if (a.block_cols == 8 && avx2_block_multiply_8(a, x, ldx, y, ldy, count)) {
+        return;
+    }
+    if (a.block_cols == 16) {
+        switch (a.block_rows) {
+        case 1:
+            avx512_block_multiply<1>(a, x, ldx, y, ldy, count);
+            return;
+        case 2:
+            avx512_block_multiply<2>(a, x, ldx, y, ldy, count);
+            return;
+        case 4:
+            avx512_block_multiply<4>(a, x, ldx, y, ldy, count);
+            return;
+        case 8:
+            avx512_block_multiply<8>(a, x, ldx, y, ldy, count);
+            return;
+        }
+    }
+    scalar_block_sparse_multiply(a, x, ldx, y, ldy, count);
+}
+
+// 8x32 tile: sixteen accumulators out of 32 zmm registers
+constexpr int kAvx512MR = 8;
+constexpr int kAvx512NR = 32;
+
+TARGET_AVX512 void avx512_micro_kernel(int depth, const float* a, const float* b, float* out) {
+    __m512 acc[kAvx512MR][2];
+    for (int i = 0; i < kAvx512MR; ++i) {
+        acc[i][0] = _mm512_setzero_ps();
+        acc[i][1] = _mm512_setzero_ps();
+    }
+    for (int p = 0; p < depth; ++p) {
+        const __m512 b0 = _mm512_loadu_ps(b);
+        const __m512 b1 = _mm512_loadu_ps(b + 16);
+        for (int i = 0; i < kAvx512MR; ++i) {
+            const __m512 a_value = _mm512_set1_ps(a[i]);
+            acc[i][0] = _mm512_fmadd_ps(a_value, b0, acc[i][0]);
+            acc[i][1] = _mm512_fmadd_ps(a_value, b1, acc[i][1]);
+        }
+        a += kAvx512MR;
+        b += kAvx512NR;
+    }
+    for (int i = 0; i < kAvx512MR; ++i) {
+        _mm512_storeu_ps(out + i * kAvx512NR, acc[i][0]);
+        _mm512_storeu_ps(out + i * kAvx512NR + 16, acc[i][1]);
+    }
+}
+
+// Without VNNI the AVX2 int8 kernel is as fast as a 512-bit maddubs one
+const Table avx512_table = {Isa::AVX512, avx512_dot, avx512_dot_rows, avx512_axpy, avx512_bias_sigmoid,
+                            avx512_momentum_update, avx512_adam_update,
+                            avx2_dot_u8s8, avx512_dot_bf16, avx512_dot_f16, avx512_block_sparse_multiply,
+                            {kAvx512MR, kAvx512NR, avx512_micro_kernel}};
+
+const Table avx512_vnni_table = {Isa::AVX512VNNI, avx512_dot, avx512_dot_rows, avx512_axpy, avx512_bias_sigmoid,
+                                 avx512_momentum_update, avx512_adam_update,
+                                 avx512_vnni_dot_u8s8, avx512_dot_bf16, avx512_dot_f16, avx512_block_sparse_multiply,
+                                 {kAvx512MR, kAvx512NR, avx512_micro_kernel}};
+
+static_assert(kAvx512MR <= kMaxMR && kAvx512NR <= kMaxNR, "Tile larger than the packing buffers");
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // MLP_KERNELS_X86
+
+const Table* detect_cpu() {
+#ifdef MLP_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c")) {
+        return __builtin_cpu_supports("avx512vnni") ? &avx512_vnni_table : &avx512_table;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c")) {
+        return &avx2_table;
+    }
+#endif
+    return &scalar_table;
+}
+
+const Table* initial_table() {
+    const char* forced = std::getenv("MLP_FORCE_SCALAR");
+    if (forced != nullptr && std::strcmp(forced, "0") != 0) {
+        return &scalar_table;
+    }
+    return detect_cpu();
+}
+
+std::atomic<const Table*> active_table{nullptr};
+
+const Table& table() {
+    const Table* current = active_table.load(std::memory_order_acquire);
+    if (current == nullptr) { // Racing first calls all detect the same table
+        current = initial_table();
+        active_table.store(current, std::memory_order_release);
+    }
+    return *current;
+}
+
+} // namespace
+
+Isa active_isa() {
+    return table().isa;
+}
+
+const char* isa_name(Isa isa) {
+    switch (isa) {
+    case Isa::AVX2:
+        return "avx2";
+    case Isa::AVX512:
+        return "avx512";
+    case Isa::AVX512VNNI:
+        return "avx512-vnni";
+    case Isa::Scalar:
+        break;
+    }
+    return "scalar";
+}
+
+void force_scalar(bool enabled) {
+    active_table.store(enabled ? &scalar_table : detect_cpu(), std::memory_order_release);
+}
+
+float dot(const float* a, const float* b, std::size_t n) {
+    return table().dot(a, b, n);
+}
+
+void dot_rows(const float* a, std::size_t lda, const float* x, std::size_t n, std::size_t rows, float* out) {
+    table().dot_rows(a, lda, x, n, rows, out);
+}
+
+void axpy(float alpha, const float* x, float* y, std::size_t n) {
+    table().axpy(alpha, x, y, n);
+}
+
+void bias_sigmoid(float* x, const float* bias, std::size_t n) {
+    table().bias_sigmoid(x, bias, n);
+}
+
+void momentum_update(float* w, const float* g, float* v, std::size_t n, const UpdateStep& step) {
+    table().momentum_update(w, g, v, n, step);
+}
+
+void adam_update(float* w, const float* g, float* m, float* v, std::size_t n, const UpdateStep& step) {
+    table().adam_update(w, g, m, v, n, step);
+}
+
+std::int32_t dot_u8s8(const std::uint8_t* a, const std::int8_t* b, std::size_t n) {
+    return table().dot_u8s8(a, b, n);
+}
+
+float dot_bf16(const float* a, const std::uint16_t* b, std::size_t n) {
+    return table().dot_bf16(a, b, n);
+}
+
+float dot_f16(const float* a, const std::uint16_t* b, std::size_t n) {
+    return table().dot_f16(a, b, n);
+}
+
+std::uint16_t float_to_bf16(float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    if ((bits & 0x7FFFFFFFu) > 0x7F800000u) {
+        return static_cast<std::uint16_t>((bits >> 16) | 0x40u); // Keep NaNs quiet
+    }
+    return static_cast<std::uint16_t>((bits + 0x7FFFu + ((bits >> 16) & 1u)) >> 16);
+}
+
+float bf16_to_float(std::uint16_t value) {
+    const std::uint32_t bits = static_cast<std::uint32_t>(value) << 16;
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+std::uint16_t float_to_f16(float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const std::uint16_t sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000u);
+    const std::uint32_t magnitude = bits & 0x7FFFFFFFu;
+    if (magnitude >= 0x7F800000u) { // Infinity or NaN
+        return sign | 0x7C00u | (magnitude > 0x7F800000u ? 0x200u : 0u);
+    }
+    if (magnitude >= 0x477FF000u) { // Rounds past the largest half
+        return sign | 0x7C00u;
+    }
+    if (magnitude >= 0x38800000u) { // Normal: rebias the exponent and round off 13 mantissa bits
+        const std::uint32_t rounded = magnitude + 0xFFFu + ((magnitude >> 13) & 1u);
+        return sign | static_cast<std::uint16_t>((rounded - 0x38000000u) >> 13);
+    }
+    if (magnitude < 0x33000000u) { // Below half the smallest subnormal
+        return sign;
+    }
+    // Subnormal: shift the full mantissa down and round to nearest even
+    const std::uint32_t mantissa = (magnitude & 0x7FFFFFu) | 0x800000u;
+    const std::uint32_t shift = 126u - (magnitude >> 23);
+    const std::uint32_t remainder = mantissa & ((1u << shift) - 1u);
+    const std::uint32_t halfway = 1u << (shift - 1u);
+    std::uint32_t result = mantissa >> shift;
+    if (remainder > halfway || (remainder == halfway && (result & 1u))) {
+        ++result;
+    }
+    return sign | static_cast<std::uint16_t>(result);
+}
+
+float f16_to_float(std::uint16_t value) {
+    const std::uint32_t sign = static_cast<std::uint32_t>(value & 0x8000u) << 16;
+    const std::uint32_t exponent = (value >> 10) & 0x1Fu;
+    const std::uint32_t mantissa = value & 0x3FFu;
+    if (exponent == 0) { // Zero or subnormal
+        const float magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign ? -magnitude : magnitude;
+    }
+    const std::uint32_t bits = exponent == 0x1Fu ? sign | 0x7F800000u | (mantissa << 13)
+                                                : sign | ((exponent + 112u) << 23) | (mantissa << 13);
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+void block_sparse_multiply(const BlockSparseMatrix& a, const float* x, std::size_t ldx, float* y,
+                           std::size_t ldy, std::size_t count) {
+    table().block_sparse_multiply(a, x, ldx, y, ldy, count);
+}
+
+const MicroKernel& micro_kernel() {
+    return table().micro_kernel;
+}
+
+} // namespace kernels
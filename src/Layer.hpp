@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include "Stats.hpp"
+
+// Alignment used for every layer buffer: one cache line, and wide enough for AVX-512 loads
+constexpr std::size_t kLayerAlignment = 64;
+
+template <typename T, std::size_t Alignment = kLayerAlignment>
+struct AlignedAllocator {
+  using value_type = T;
+
+  template <typename U> struct rebind {
+    using other = AlignedAllocator<U, Alignment>;
+  };
+
+  AlignedAllocator() = default;
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept {}
+
+  T *allocate(std::size_t n) {
+    if constexpr (stats::kEnabled) {
+      stats::count_allocation(n * sizeof(T));
+    }
+    return static_cast<T *>(
+        ::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+  }
+  void deallocate(T *p, std::size_t) noexcept {
+    ::operator delete(p, std::align_val_t(Alignment));
+  }
+
+  template <typename U>
+  bool operator==(const AlignedAllocator<U, Alignment> &) const noexcept {
+    return true;
+  }
+};
+
+template <typename T> using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// Number of floats that fills whole cache lines
+constexpr std::size_t aligned_floats(std::size_t count) {
+  constexpr std::size_t floats_per_line = kLayerAlignment / sizeof(float);
+  return (count + floats_per_line - 1) / floats_per_line * floats_per_line;
+}
+
+// Non-owning view of one dense layer: a row-major [outputs x inputs] weight
+// matrix whose rows start on a cache line (stride >= inputs), plus a bias vector
+struct LayerView {
+  int inputs = 0;
+  int outputs = 0;
+  std::size_t stride = 0; // Floats between the starts of two neuron rows
+  float *weights = nullptr;
+  float *biases = nullptr;
+
+  float *row(int neuron) const {
+    return weights + static_cast<std::size_t>(neuron) * stride;
+  }
+  // Floats taken by this layer's weights and biases inside a parameter buffer
+  static std::size_t footprint(int inputs, int outputs) {
+    return static_cast<std::size_t>(outputs) * aligned_floats(inputs) +
+           aligned_floats(outputs);
+  }
+};
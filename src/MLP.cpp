@@ -0,0 +1,941 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <fstream>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <cstdlib>  // Include for rand and srand
+#include <ctime>    // Include for time
+
+// MLP.cpp
+#include "MLP.hpp"
+#include "Dataset.hpp"
+#include "Gemm.hpp"
+#include "Kernels.hpp"
+#include "MappedFile.hpp"
+#include "SparseMLP.hpp"
+#include "ThreadPool.hpp"
+
+MLP::MLP(const std::vector<int>& layers, float learning_rate) : learning_rate(learning_rate) {
+    if (layers.size() < 2) {
+        throw std::invalid_argument("There must be at least two layers (input and output).");
+    }
+
+    for (int layer_size : layers) {
+        if (layer_size <= 0) {
+            throw std::invalid_argument("Layer sizes must be greater than zero.");
+        }
+    }
+
+    // Initialize random seed
+    srand(static_cast<unsigned int>(time(nullptr)));
+
+    allocate(layers);
+
+    // Initialize weights and biases
+    for (const LayerView& layer : layer_views) {
+        for (int j = 0; j < layer.outputs; ++j) {
+            float* row = layer.row(j);
+            for (int k = 0; k < layer.inputs; ++k) {
+                row[k] = static_cast<float>(rand()) / RAND_MAX * 2 - 1; // Random weights in [-1, 1]
+            }
+        }
+
+        for (int j = 0; j < layer.outputs; ++j) {
+            layer.biases[j] = static_cast<float>(rand()) / RAND_MAX * 0.1f; // Small random values
+        }
+    }
+}
+
+void MLP::allocate(const std::vector<int>& layers) {
+    // One zeroed buffer for every layer, so row padding stays zero
+    layer_sizes = layers;
+    size_t total = 0;
+    for (size_t i = 1; i < layers.size(); ++i) {
+        total += LayerView::footprint(layers[i - 1], layers[i]);
+    }
+    parameters.assign(total, 0.0f);
+    bind_layers(parameters.data());
+}
+
+void MLP::bind_layers(float* base) {
+    layer_views.clear();
+    parameter_count = 0;
+    for (size_t i = 1; i < layer_sizes.size(); ++i) {
+        LayerView layer;
+        layer.inputs = layer_sizes[i - 1];
+        layer.outputs = layer_sizes[i];
+        layer.stride = aligned_floats(layer.inputs);
+        layer.weights = base;
+        layer.biases = base + layer.outputs * layer.stride;
+        layer_views.push_back(layer);
+        base += LayerView::footprint(layer.inputs, layer.outputs);
+        parameter_count += LayerView::footprint(layer.inputs, layer.outputs);
+    }
+    if constexpr (stats::kEnabled) {
+        counters = std::make_unique<stats::ModelCounters>(layer_views.size());
+    }
+}
+
+MLP::MLP(MLP&&) = default;
+MLP& MLP::operator=(MLP&&) = default;
+MLP::~MLP() = default;
+
+void MLP::train(const std::vector<std::vector<float>>& inputs, const std::vector<std::vector<float>>& labels, int epochs, int batch_size) {
+    TrainOptions options;
+    options.batch_size = batch_size;
+    train(inputs, labels, epochs, options);
+}
+
+void MLP::train(const std::vector<std::vector<float>>& inputs, const std::vector<std::vector<float>>& labels, int epochs, const TrainOptions& options) {
+    MemoryDataset data(inputs, labels);
+    if (options.validation_fraction > 0.0f && !options.validation) {
+        if (options.validation_fraction >= 1.0f) {
+            throw std::invalid_argument("The validation fraction must be below one.");
+        }
+        const size_t held_out = std::max<size_t>(1, static_cast<size_t>(options.validation_fraction * data.size()));
+        MemoryDataset validation = data.split_tail(held_out);
+        TrainOptions split = options;
+        split.validation = &validation;
+        train(data, epochs, split);
+        return;
+    }
+    train(data, epochs, options);
+}
+
+void MLP::train(Dataset& data, int epochs, const TrainOptions& options) {
+    if (options.batch_size < 1) {
+        throw std::invalid_argument("Batch size must be at least one.");
+    }
+    if (options.first_epoch < 0) {
+        throw std::invalid_argument("The first epoch cannot be negative.");
+    }
+    if (data.input_size() != layer_sizes.front() || data.label_size() != layer_sizes.back()) {
+        throw std::invalid_argument("Sample size does not match the input or output layer size.");
+    }
+    if (options.learning_rate < 0.0f || options.patience < 0 || options.min_delta < 0.0f || options.target_loss < 0.0f) {
+        throw std::invalid_argument("Learning rate, patience, min delta and target loss cannot be negative.");
+    }
+    const float peak_rate = options.learning_rate > 0.0f ? options.learning_rate : learning_rate;
+
+    // A fresh run starts the optimizer from zero; a continued one keeps its
+    // moments as long as the optimizer is the same
+    const size_t moment_floats = static_cast<size_t>(optimizer_slots(options.optimizer.kind)) * parameter_count;
+    if (options.first_epoch == 0 || options.optimizer.kind != optimizer.kind || moments.size() != moment_floats) {
+        moments.assign(moment_floats, 0.0f);
+        optimizer_step = 0;
+    }
+    optimizer = options.optimizer;
+    if (options.first_epoch == 0) {
+        best_loss = std::numeric_limits<float>::infinity();
+        stale_epochs = 0;
+        best_parameters.clear();
+    }
+
+    ThreadPool& workers = thread_pool(options.threads);
+    const size_t batch = static_cast<size_t>(options.batch_size);
+    const bool hogwild = options.parallelism == Parallelism::Hogwild;
+
+    // Hogwild workers each step through their own batches; synchronous training
+    // shares one batch workspace and gives every extra worker a gradient buffer.
+    // Momentum and Adam also need a gradient buffer per single-worker step.
+    // All of it is kept between calls and only grows when the shape changes.
+    training_workspaces.resize(hogwild ? workers.size() : 1);
+    for (Workspace& workspace : training_workspaces) {
+        workspace.reserve(layer_sizes, batch);
+    }
+    size_t gradient_buffers = 0;
+    if (!hogwild && workers.size() > 1) {
+        gradient_buffers = workers.size();
+    } else if (optimizer.kind != Optimizer::SGD) {
+        gradient_buffers = hogwild ? workers.size() : 1;
+    }
+    gradients.resize(gradient_buffers);
+    for (AlignedVector<float>& gradient : gradients) {
+        gradient.resize(parameter_count);
+    }
+    worker_losses.resize(workers.size());
+    worker_samples.resize(workers.size());
+    // Hogwild workers may see their first packed gemm in any epoch
+    workers.run([](int) { reserve_gemm_buffers(); });
+
+    // Snapshots are copied out between epochs and written by a background thread
+    std::unique_ptr<Checkpointer> checkpointer;
+    if (!options.checkpoint_path.empty()) {
+        checkpointer = std::make_unique<Checkpointer>(options.checkpoint_path, describe());
+    }
+    auto last_checkpoint = std::chrono::steady_clock::now();
+
+    for (int epoch = options.first_epoch; epoch < epochs; ++epoch) {
+        const auto epoch_start = std::chrono::steady_clock::now();
+        const uint64_t allocations = stats::allocation_count();
+        const uint64_t allocated_bytes = stats::allocated_bytes();
+        if constexpr (stats::kEnabled) {
+            counters->reset();
+        }
+
+        const float rate = scheduled_learning_rate(options.schedule, peak_rate, epoch, epochs);
+        data.start_epoch(epoch, batch);
+        size_t samples = 0;
+        float total_loss = hogwild ? train_hogwild(data, rate, samples) : train_synchronous(data, rate, samples);
+
+        average_loss = total_loss / std::max<size_t>(samples * layer_sizes.back(), 1); // Mean squared error
+
+        // Early stopping on the validation loss, or the training loss without a validation set
+        const float validation_loss = options.validation ? evaluate(*options.validation) : -1.0f;
+        const float monitored = options.validation ? validation_loss : average_loss;
+        if (monitored < best_loss - options.min_delta) {
+            best_loss = monitored;
+            stale_epochs = 0;
+            if (options.validation) {
+                best_parameters.assign(layer_views.front().weights, layer_views.front().weights + parameter_count);
+            }
+        } else {
+            ++stale_epochs;
+        }
+        const bool reached = options.target_loss > 0.0f && monitored <= options.target_loss;
+        const bool stalled = options.patience > 0 && stale_epochs >= static_cast<uint32_t>(options.patience);
+        const bool last = epoch == epochs - 1 || reached || stalled;
+
+        if (stats_callback) {
+            EpochStats report;
+            report.epoch = epoch + 1;
+            report.epochs = epochs;
+            report.samples = samples;
+            report.loss = average_loss;
+            report.validation_loss = validation_loss;
+            report.learning_rate = rate;
+            report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - epoch_start).count();
+            if constexpr (stats::kEnabled) {
+                for (size_t i = 0; i < layer_views.size(); ++i) {
+                    const stats::LayerCounters& layer = counters->layers[i];
+                    report.layers.push_back({stats::seconds(layer.forward), stats::seconds(layer.backward), stats::seconds(layer.update)});
+                }
+                report.all_reduce_seconds = stats::seconds(counters->all_reduce);
+                report.allocations = stats::allocation_count() - allocations;
+                report.allocated_bytes = stats::allocated_bytes() - allocated_bytes;
+            }
+            stats_callback(report);
+        }
+
+        // Restore the best weights before the final checkpoint, so resuming
+        // continues from the weights the caller ends up with
+        if (last && !best_parameters.empty()) {
+            std::copy(best_parameters.begin(), best_parameters.end(), layer_views.front().weights);
+        }
+
+        if (checkpointer) {
+            const auto now = std::chrono::steady_clock::now();
+            const bool due = last ||
+                             (options.checkpoint_epochs > 0 && (epoch + 1) % options.checkpoint_epochs == 0) ||
+                             (options.checkpoint_seconds > 0.0 &&
+                              std::chrono::duration<double>(now - last_checkpoint).count() >= options.checkpoint_seconds);
+            if (due) {
+                TrainingState state;
+                state.epoch = static_cast<uint32_t>(epoch + 1);
+                state.average_loss = average_loss;
+                state.data_seed = data.shuffle_seed();
+                state.optimizer = static_cast<uint32_t>(optimizer.kind);
+                state.optimizer_step = optimizer_step;
+                state.moment_floats = moments.size();
+                state.best_loss = best_loss;
+                state.stale_epochs = stale_epochs;
+                if (pruned()) {
+                    state.prune_block_rows = static_cast<uint32_t>(prune_block_rows);
+                    state.prune_block_cols = static_cast<uint32_t>(prune_block_cols);
+                }
+                checkpointer->submit(layer_views.front().weights, state, moments.data(),
+                                     best_parameters.empty() ? nullptr : best_parameters.data());
+                last_checkpoint = now;
+            }
+        }
+
+        // Show progress in terminal
+        if ((options.report_epochs > 0 && (epoch + 1) % options.report_epochs == 0) || last) {
+            std::cout << "Epoch " << (epoch + 1) << "/" << epochs << " - Loss: " << average_loss;
+            if (options.validation) {
+                std::cout << " - Validation loss: " << validation_loss;
+            }
+            std::cout << std::endl;
+        }
+        if (reached) {
+            std::cout << "Reached the target loss after epoch " << (epoch + 1) << std::endl;
+            break;
+        }
+        if (stalled) {
+            std::cout << "Stopping early: no improvement in " << options.patience << " epochs" << std::endl;
+            break;
+        }
+    }
+
+    if (checkpointer) {
+        checkpointer->finish();
+    }
+}
+
+float MLP::train_synchronous(Dataset& data, float rate, size_t& samples) {
+    ThreadPool& workers = *pool;
+    const int threads = workers.size();
+    Workspace& batch = training_workspaces.front();
+    float total_loss = 0.0f;
+
+    Batch next;
+    while (data.next(next)) {
+        const int count = next.count;
+        samples += count;
+
+        if (threads == 1) {
+            stack_batch(batch, next, 0, count);
+            forward_rows(batch, 0, count);
+            total_loss += backward_rows(batch, 0, count);
+            if (optimizer.kind == Optimizer::SGD) { // Apply the averaged gradient straight to the weights
+                accumulate_gradients(batch, 0, count, -(rate / count), false, layer_views.front().weights);
+                apply_prune_mask(0, parameter_count);
+            } else {
+                update_layers(batch, count, rate, gradients.front().data());
+            }
+            continue;
+        }
+
+        const uint64_t step = next_optimizer_step();
+        SpinBarrier barrier(threads);
+        workers.run([&](int worker) {
+            // Each worker takes a contiguous slice of the batch rows
+            const int first = count * worker / threads;
+            const int rows = count * (worker + 1) / threads - first;
+            stack_batch(batch, next, first, rows);
+            forward_rows(batch, first, rows);
+            worker_losses[worker] = backward_rows(batch, first, rows);
+            accumulate_gradients(batch, first, rows, 1.0f, true, gradients[worker].data());
+
+            // Tree all-reduce into gradients[0]. Every level adds pairs of
+            // buffers, and each worker sums its own chunk of every pair.
+            MLP_STATS_TIMER(reduce_timer, counters->all_reduce);
+            const size_t size = gradients.front().size();
+            const size_t begin = std::min(size, aligned_floats(size * worker / threads));
+            const size_t end = worker == threads - 1 ? size : std::min(size, aligned_floats(size * (worker + 1) / threads));
+            for (int span = 1; span < threads; span *= 2) {
+                barrier.wait();
+                for (int left = 0; left + span < threads; left += 2 * span) {
+                    kernels::axpy(1.0f, gradients[left + span].data() + begin, gradients[left].data() + begin, end - begin);
+                }
+            }
+            barrier.wait();
+            apply_update(begin, end, gradients.front().data() + begin, rate, count, step);
+        });
+        for (int worker = 0; worker < threads; ++worker) {
+            total_loss += worker_losses[worker];
+        }
+    }
+    return total_loss;
+}
+
+float MLP::train_hogwild(Dataset& data, float rate, size_t& samples) {
+    const int threads = pool->size();
+    std::mutex feed; // Datasets are single-consumer
+    bool failed = false; // A worker's next() threw; the pool rethrows it once every worker is out
+
+    pool->run([&](int worker) {
+        Workspace& batch = training_workspaces[worker];
+        worker_losses[worker] = 0.0f;
+        worker_samples[worker] = 0;
+        for (;;) {
+            int count;
+            {
+                // Copy the batch out while holding the dataset, then train unlocked
+                std::lock_guard<std::mutex> lock(feed);
+                Batch next;
+                if (failed) {
+                    break;
+                }
+                try {
+                    if (!data.next(next)) {
+                        break;
+                    }
+                } catch (...) {
+                    failed = true;
+                    throw;
+                }
+                count = next.count;
+                stack_batch(batch, next, 0, count);
+            }
+            worker_samples[worker] += count;
+            forward_rows(batch, 0, count);
+            worker_losses[worker] += backward_rows(batch, 0, count);
+            // Deliberately unsynchronized: other workers read and write the same
+            // weights and moments concurrently, and lost or stale updates are tolerated
+            if (optimizer.kind == Optimizer::SGD) {
+                accumulate_gradients(batch, 0, count, -(rate / count), false, layer_views.front().weights);
+                apply_prune_mask(0, parameter_count);
+            } else {
+                update_layers(batch, count, rate, gradients[worker].data());
+            }
+        }
+    });
+
+    float total_loss = 0.0f;
+    for (int worker = 0; worker < threads; ++worker) {
+        total_loss += worker_losses[worker];
+        samples += worker_samples[worker];
+    }
+    return total_loss;
+}
+
+void MLP::stack_batch(Workspace& batch, const Batch& rows, int first, int count) const {
+    const size_t output_layer = layer_sizes.size() - 1;
+    for (int b = first; b < first + count; ++b) {
+        std::copy_n(rows.inputs[b], layer_sizes.front(), batch.activations(0) + b * batch.stride(0));
+        std::copy_n(rows.labels[b], layer_sizes.back(), batch.targets() + b * batch.stride(output_layer));
+    }
+}
+
+void MLP::forward_rows(Workspace& batch, int first, int count) const {
+    // A[i + 1] = f(A[i] * W[i]^T + bias[i])
+    for (size_t i = 0; i < layer_views.size(); ++i) {
+        MLP_STATS_TIMER(timer, counters->layers[i].forward);
+        const LayerView& layer = layer_views[i];
+        const size_t in_stride = batch.stride(i);
+        const size_t out_stride = batch.stride(i + 1);
+        float* out = batch.activations(i + 1) + first * out_stride;
+        gemm(Transpose::No, Transpose::Yes, count, layer.outputs, layer.inputs,
+             1.0f, batch.activations(i) + first * in_stride, in_stride, layer.weights, layer.stride,
+             0.0f, out, out_stride);
+        for (int b = 0; b < count; ++b) {
+            activation_function(out + b * out_stride, layer.biases, layer.outputs);
+        }
+    }
+}
+
+float MLP::backward_rows(Workspace& batch, int first, int count) const {
+    const size_t layer_count = layer_views.size();
+    float loss = 0.0f;
+
+    // Output layer
+    {
+        MLP_STATS_TIMER(timer, counters->layers[layer_count - 1].backward);
+        const size_t out_stride = batch.stride(layer_count);
+        for (int b = first; b < first + count; ++b) {
+            const float* output = batch.activations(layer_count) + b * out_stride;
+            const float* label = batch.targets() + b * out_stride;
+            float* delta = batch.deltas(layer_count - 1) + b * out_stride;
+            for (int j = 0; j < layer_sizes.back(); ++j) {
+                const float error = output[j] - label[j];
+                delta[j] = error * activation_derivative(output[j]);
+                loss += error * error;
+            }
+        }
+    }
+
+    // Hidden layers: D[i] = (D[i + 1] * W[i + 1]) .* f'(A[i + 1])
+    for (size_t i = layer_count - 1; i-- > 0;) {
+        MLP_STATS_TIMER(timer, counters->layers[i].backward);
+        const LayerView& layer = layer_views[i];
+        const LayerView& next = layer_views[i + 1];
+        const size_t stride = batch.stride(i + 1);
+        const size_t next_stride = batch.stride(i + 2);
+        gemm(Transpose::No, Transpose::No, count, layer.outputs, next.outputs,
+             1.0f, batch.deltas(i + 1) + first * next_stride, next_stride, next.weights, next.stride,
+             0.0f, batch.deltas(i) + first * stride, stride);
+        for (int b = first; b < first + count; ++b) {
+            const float* activation = batch.activations(i + 1) + b * stride;
+            float* delta = batch.deltas(i) + b * stride;
+            for (int j = 0; j < layer.outputs; ++j) {
+                delta[j] *= activation_derivative(activation[j]);
+            }
+        }
+    }
+    return loss;
+}
+
+void MLP::accumulate_gradients(const Workspace& batch, int first, int count, float alpha, bool overwrite, float* target) {
+    for (size_t i = 0; i < layer_views.size(); ++i) {
+        layer_gradient(batch, i, first, count, alpha, overwrite, target);
+    }
+}
+
+void MLP::layer_gradient(const Workspace& batch, size_t i, int first, int count, float alpha, bool overwrite, float* target) {
+    MLP_STATS_TIMER(timer, counters->layers[i].update);
+    const float* base = layer_views.front().weights;
+    const LayerView& layer = layer_views[i];
+    const size_t in_stride = batch.stride(i);
+    const size_t out_stride = batch.stride(i + 1);
+    const float* deltas = batch.deltas(i) + first * out_stride;
+    float* weights = target + (layer.weights - base);
+    float* biases = target + (layer.biases - base);
+
+    // dW = D^T * A, summed over the rows
+    gemm(Transpose::Yes, Transpose::No, layer.outputs, layer.inputs, count,
+         alpha, deltas, out_stride, batch.activations(i) + first * in_stride, in_stride,
+         overwrite ? 0.0f : 1.0f, weights, layer.stride);
+    if (overwrite) {
+        std::fill(biases, biases + layer.outputs, 0.0f);
+    }
+    for (int b = 0; b < count; ++b) {
+        kernels::axpy(alpha, deltas + b * out_stride, biases, layer.outputs);
+    }
+}
+
+void MLP::update_layers(const Workspace& batch, int count, float rate, float* gradient) {
+    const uint64_t step = next_optimizer_step();
+    const float* base = layer_views.front().weights;
+    for (size_t i = 0; i < layer_views.size(); ++i) {
+        const LayerView& layer = layer_views[i];
+        const size_t begin = layer.weights - base;
+        layer_gradient(batch, i, 0, count, 1.0f, true, gradient);
+        MLP_STATS_TIMER(timer, counters->layers[i].update);
+        apply_update(begin, begin + LayerView::footprint(layer.inputs, layer.outputs), gradient + begin, rate, count, step);
+    }
+}
+
+void MLP::apply_update(size_t begin, size_t end, const float* gradient, float rate, int count, uint64_t step) {
+    float* weights = layer_views.front().weights + begin;
+    const size_t n = end - begin;
+    if (optimizer.kind == Optimizer::SGD) {
+        kernels::axpy(-(rate / count), gradient, weights, n);
+    } else {
+        kernels::UpdateStep update;
+        update.grad_scale = 1.0f / count; // Average the gradient over the batch
+        update.rate = rate;
+        update.beta1 = optimizer.momentum;
+        update.beta2 = optimizer.beta2;
+        update.epsilon = optimizer.epsilon;
+        if (optimizer.kind == Optimizer::Momentum) {
+            kernels::momentum_update(weights, gradient, moments.data() + begin, n, update);
+        } else {
+            // rate * m_hat / (sqrt(v_hat) + eps) with the bias corrections moved onto rate and eps
+            const double first_correction = 1.0 - std::pow(static_cast<double>(optimizer.momentum), static_cast<double>(step));
+            const double second_correction = std::sqrt(1.0 - std::pow(static_cast<double>(optimizer.beta2), static_cast<double>(step)));
+            update.rate = static_cast<float>(rate * second_correction / first_correction);
+            update.epsilon = static_cast<float>(optimizer.epsilon * second_correction);
+            kernels::adam_update(weights, gradient, moments.data() + begin, moments.data() + parameter_count + begin, n, update);
+        }
+    }
+    apply_prune_mask(begin, end);
+}
+
+uint64_t MLP::next_optimizer_step() {
+    // Hogwild workers count concurrently
+    return std::atomic_ref<uint64_t>(optimizer_step).fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void MLP::apply_prune_mask(size_t begin, size_t end) {
+    if (prune_mask.empty()) {
+        return;
+    }
+    float* weights = layer_views.front().weights;
+    for (size_t i = begin; i < end; ++i) {
+        weights[i] = prune_mask[i] ? weights[i] : 0.0f; // Branch-free, so it vectorizes
+    }
+}
+
+void MLP::mask_zero_tiles(size_t i, int block_rows, int block_cols) {
+    if (prune_mask.empty()) {
+        prune_mask.assign(parameter_count, 1);
+    }
+    const LayerView& layer = layer_views[i];
+    unsigned char* mask = prune_mask.data() + (layer.weights - layer_views.front().weights);
+    for (int row0 = 0; row0 < layer.outputs; row0 += block_rows) {
+        const int rows = std::min(block_rows, layer.outputs - row0);
+        for (int col0 = 0; col0 < layer.inputs; col0 += block_cols) {
+            const int cols = std::min(block_cols, layer.inputs - col0);
+            bool zero = true;
+            for (int r = 0; r < rows && zero; ++r) {
+                const float* row = layer.row(row0 + r) + col0;
+                zero = std::all_of(row, row + cols, [](float w) { return w == 0.0f; });
+            }
+            for (int r = 0; r < rows && zero; ++r) {
+                std::fill_n(mask + (row0 + r) * layer.stride + col0, cols, 0);
+            }
+        }
+    }
+    prune_block_rows = block_rows;
+    prune_block_cols = block_cols;
+}
+
+void MLP::prune(const PruneOptions& options) {
+    if (!(options.sparsity >= 0.0f && options.sparsity < 1.0f)) {
+        throw std::invalid_argument("Sparsity must be in [0, 1).");
+    }
+    check_sparse_block(options.block_rows, options.block_cols);
+    if (prune_mask.empty()) {
+        prune_mask.assign(parameter_count, 1);
+    }
+
+    const float* base = layer_views.front().weights;
+    for (const LayerView& layer : layer_views) {
+        if (static_cast<size_t>(layer.outputs) * layer.inputs < options.min_weights) {
+            continue;
+        }
+        // L1 norm of every tile; edge tiles only count the weights they cover
+        const int tile_rows = (layer.outputs + options.block_rows - 1) / options.block_rows;
+        const int tile_cols = (layer.inputs + options.block_cols - 1) / options.block_cols;
+        std::vector<float> norms(static_cast<size_t>(tile_rows) * tile_cols, 0.0f);
+        for (int j = 0; j < layer.outputs; ++j) {
+            const float* row = layer.row(j);
+            float* tile_norms = norms.data() + static_cast<size_t>(j / options.block_rows) * tile_cols;
+            for (int k = 0; k < layer.inputs; ++k) {
+                tile_norms[k / options.block_cols] += std::fabs(row[k]);
+            }
+        }
+
+        // Zero the weakest tiles; ties go to the lower index, so pruning is deterministic
+        std::vector<uint32_t> order(norms.size());
+        std::iota(order.begin(), order.end(), 0u);
+        const size_t pruned_tiles = static_cast<size_t>(options.sparsity * norms.size());
+        std::nth_element(order.begin(), order.begin() + pruned_tiles, order.end(), [&](uint32_t a, uint32_t b) {
+            return norms[a] < norms[b] || (norms[a] == norms[b] && a < b);
+        });
+        unsigned char* mask = prune_mask.data() + (layer.weights - base);
+        for (size_t t = 0; t < pruned_tiles; ++t) {
+            const int row0 = static_cast<int>(order[t] / tile_cols) * options.block_rows;
+            const int col0 = static_cast<int>(order[t] % tile_cols) * options.block_cols;
+            const int rows = std::min(options.block_rows, layer.outputs - row0);
+            const int cols = std::min(options.block_cols, layer.inputs - col0);
+            for (int r = 0; r < rows; ++r) {
+                std::fill_n(layer.row(row0 + r) + col0, cols, 0.0f);
+                std::fill_n(mask + (row0 + r) * layer.stride + col0, cols, 0);
+            }
+        }
+    }
+    prune_block_rows = options.block_rows;
+    prune_block_cols = options.block_cols;
+    best_parameters.clear(); // Taken before pruning, they would bring the pruned tiles back
+}
+
+ThreadPool& MLP::thread_pool(int threads) {
+    if (threads < 1) {
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    if (!pool || pool->size() != threads) {
+        pool = std::make_unique<ThreadPool>(threads);
+    }
+    return *pool;
+}
+
+std::vector<float> MLP::predict(const std::vector<float>& input) {
+    std::vector<float> output(layer_sizes.back());
+    predict(input, output);
+    return output;
+}
+
+void MLP::predict(std::span<const float> input, std::span<float> output) {
+    predict(input, output, inference_workspace);
+}
+
+void MLP::predict(std::span<const float> input, std::span<float> output, Workspace& workspace) const {
+    if (input.size() != static_cast<size_t>(layer_sizes.front())) {
+        throw std::invalid_argument("Input size does not match the input layer size.");
+    }
+    if (output.size() != static_cast<size_t>(layer_sizes.back())) {
+        throw std::invalid_argument("Output size does not match the output layer size.");
+    }
+
+    predict_batch(input.data(), input.size(), output.data(), output.size(), 1, workspace);
+}
+
+void MLP::predict_batch(const float* inputs, size_t input_stride, float* outputs, size_t output_stride,
+                        int count, Workspace& workspace) const {
+    const float* results = feedforward(inputs, input_stride, count, workspace);
+    const size_t result_stride = workspace.stride(layer_sizes.size() - 1);
+    for (int b = 0; b < count; ++b) {
+        blend_output(results + b * result_stride, inputs + b * input_stride, outputs + b * output_stride);
+    }
+}
+
+void MLP::predict_rows(std::span<const float* const> inputs, std::span<float* const> outputs, Workspace& workspace) const {
+    const int count = static_cast<int>(inputs.size());
+    workspace.reserve(layer_sizes, count);
+    for (int b = 0; b < count; ++b) {
+        std::copy_n(inputs[b], layer_sizes.front(), workspace.activations(0) + b * workspace.stride(0));
+    }
+    forward_rows(workspace, 0, count);
+
+    const float* results = workspace.activations(layer_sizes.size() - 1);
+    const size_t result_stride = workspace.stride(layer_sizes.size() - 1);
+    for (int b = 0; b < count; ++b) {
+        blend_output(results + b * result_stride, inputs[b], outputs[b]);
+    }
+}
+
+void MLP::blend_output(const float* result, const float* input, float* output) const {
+    // Blend output with input based on the average loss
+    float blending_factor = std::min(1.0f, average_loss); // Ensure blending factor is between 0 and 1
+    for (int i = 0; i < layer_sizes.back(); ++i) {
+        output[i] = (1 - blending_factor) * result[i] + blending_factor * input[i]; // Blend
+    }
+}
+
+MLP MLP::from_file(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file to load model.");
+    }
+    ModelDescription description = read_description(file);
+    if (description.header.version == kSparseModelVersion) {
+        return SparseMLP::open_mapped(filename, true).unpack();
+    }
+
+    MLP mlp;
+    mlp.learning_rate = description.header.learning_rate;
+    mlp.allocate(description.layer_sizes);
+    mlp.read_parameters(file, description);
+    return mlp;
+}
+
+MLP MLP::open_mapped(const std::string& filename, bool verify_checksum) {
+    auto mapping = std::make_unique<MappedFile>(filename);
+    ModelDescription description = parse_model_description(mapping->data(), mapping->size(), mapping->size());
+    if (description.header.version == kSparseModelVersion) {
+        return from_file(filename); // Sparse layers have no dense form to map
+    }
+
+    MLP mlp;
+    mlp.learning_rate = description.header.learning_rate;
+    mlp.layer_sizes = description.layer_sizes;
+    mlp.bind_layers(reinterpret_cast<float*>(mapping->data() + description.header.payload_offset));
+    mlp.check_layout(description);
+    if (verify_checksum && model_checksum(mlp.layer_views.front().weights, description.header.payload_bytes) != description.header.checksum) {
+        throw std::runtime_error("Model file checksum mismatch.");
+    }
+    mlp.mapping = std::move(mapping);
+    return mlp;
+}
+
+MLP MLP::resume(const std::string& checkpoint, TrainingState& state) {
+    state = read_checkpoint_state(checkpoint);
+    MLP mlp = from_file(checkpoint);
+    mlp.average_loss = state.average_loss; // Predictions blend by it
+    mlp.optimizer.kind = static_cast<Optimizer>(state.optimizer);
+    mlp.optimizer_step = state.optimizer_step;
+    mlp.best_loss = state.best_loss;
+    mlp.stale_epochs = state.stale_epochs;
+    if (state.moment_floats != static_cast<uint64_t>(optimizer_slots(mlp.optimizer.kind)) * mlp.parameter_count) {
+        throw std::runtime_error("Checkpoint optimizer state does not match the model.");
+    }
+    mlp.moments.resize(state.moment_floats);
+    read_checkpoint_moments(checkpoint, state, mlp.moments.data());
+    if (state.best_weights) {
+        mlp.best_parameters.resize(mlp.parameter_count);
+        read_checkpoint_best_weights(checkpoint, state, mlp.best_parameters.data());
+    }
+    if (state.prune_block_rows > 0) {
+        check_sparse_block(static_cast<int>(state.prune_block_rows), static_cast<int>(state.prune_block_cols));
+        for (size_t i = 0; i < mlp.layer_views.size(); ++i) {
+            mlp.mask_zero_tiles(i, static_cast<int>(state.prune_block_rows), static_cast<int>(state.prune_block_cols));
+        }
+    }
+    return mlp;
+}
+
+float MLP::evaluate(Dataset& data, int batch_size) {
+    if (data.input_size() != layer_sizes.front() || data.label_size() != layer_sizes.back()) {
+        throw std::invalid_argument("Sample size does not match the input or output layer size.");
+    }
+    if (batch_size < 1) {
+        throw std::invalid_argument("Batch size must be at least one.");
+    }
+    Workspace& batch = inference_workspace;
+    batch.reserve(layer_sizes, batch_size);
+    const size_t output_layer = layer_sizes.size() - 1;
+    const size_t stride = batch.stride(output_layer);
+
+    double total = 0.0;
+    size_t samples = 0;
+    data.start_epoch(0, batch_size);
+    Batch next;
+    while (data.next(next)) {
+        stack_batch(batch, next, 0, next.count);
+        forward_rows(batch, 0, next.count);
+        for (int b = 0; b < next.count; ++b) {
+            const float* output = batch.activations(output_layer) + b * stride;
+            const float* label = batch.targets() + b * stride;
+            for (int j = 0; j < layer_sizes.back(); ++j) {
+                const float error = output[j] - label[j];
+                total += error * error;
+            }
+        }
+        samples += next.count;
+    }
+    return static_cast<float>(total / std::max<size_t>(samples * layer_sizes.back(), 1));
+}
+
+void MLP::save_model(const std::string& filename) {
+    if (pruned()) {
+        SparseMLP(*this, FormatPolicy::Fastest, prune_block_rows, prune_block_cols).save_model(filename);
+        return;
+    }
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file to save model.");
+    }
+
+    // The payload is the parameter buffer itself, padding included, so it can be mapped back in place
+    ModelDescription description = describe();
+    const float* payload = layer_views.front().weights;
+    description.header.checksum = model_checksum(payload, description.header.payload_bytes);
+    write_model_description(file, description);
+    file.write(reinterpret_cast<const char*>(payload), description.header.payload_bytes);
+
+    if (!file) {
+        throw std::runtime_error("Could not write model file.");
+    }
+}
+
+void MLP::load_model(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file to load model.");
+    }
+    const std::streamoff file_size = file.tellg();
+    file.seekg(0);
+
+    unsigned char magic[sizeof(kModelMagic)] = {};
+    file.read(reinterpret_cast<char*>(magic), sizeof(magic));
+    file.clear();
+    file.seekg(0);
+    if (has_model_magic(magic, static_cast<size_t>(file.gcount()))) {
+        ModelDescription description = read_description(file);
+        if (description.layer_sizes != layer_sizes) {
+            throw std::invalid_argument("Model file topology does not match this network.");
+        }
+        if (description.header.version == kSparseModelVersion) {
+            MLP loaded = SparseMLP::open_mapped(filename, true).unpack();
+            std::copy_n(loaded.layer_views.front().weights, parameter_count, layer_views.front().weights);
+            prune_mask = std::move(loaded.prune_mask);
+            prune_block_rows = loaded.prune_block_rows;
+            prune_block_cols = loaded.prune_block_cols;
+            return;
+        }
+        read_parameters(file, description);
+        return;
+    }
+
+    // Headerless files from older builds: rows without padding, then every bias vector
+    std::streamoff expected = 0;
+    for (const LayerView& layer : layer_views) {
+        expected += static_cast<std::streamoff>(layer.outputs) * (layer.inputs + 1) * sizeof(float);
+    }
+    if (file_size != expected) {
+        throw std::invalid_argument("Model file size does not match this network's topology.");
+    }
+
+    for (const LayerView& layer : layer_views) {
+        for (int j = 0; j < layer.outputs; ++j) {
+            file.read(reinterpret_cast<char*>(layer.row(j)), layer.inputs * sizeof(float));
+        }
+    }
+
+    for (const LayerView& layer : layer_views) {
+        file.read(reinterpret_cast<char*>(layer.biases), layer.outputs * sizeof(float));
+    }
+}
+
+ModelDescription MLP::describe() const {
+    ModelDescription description;
+    ModelHeader& header = description.header;
+    std::memcpy(header.magic, kModelMagic, sizeof(kModelMagic));
+    header.version = kModelVersion;
+    header.dtype = static_cast<uint32_t>(DType::F32);
+    header.activation = static_cast<uint32_t>(Activation::Sigmoid);
+    header.layer_count = static_cast<uint32_t>(layer_sizes.size());
+    header.tensor_count = static_cast<uint32_t>(2 * layer_views.size());
+    header.learning_rate = learning_rate;
+    description.layer_sizes = layer_sizes;
+    description.tensors.resize(header.tensor_count);
+    header.payload_offset = align_offset(description.header_bytes());
+    header.payload_bytes = parameter_count * sizeof(float);
+
+    // Weights then biases per layer, at their offsets inside the parameter buffer
+    const float* base = layer_views.front().weights;
+    for (size_t i = 0; i < layer_views.size(); ++i) {
+        const LayerView& layer = layer_views[i];
+        TensorEntry& weights = description.tensors[2 * i];
+        weights.offset = header.payload_offset + (layer.weights - base) * sizeof(float);
+        weights.bytes = layer.outputs * layer.stride * sizeof(float);
+        weights.rows = layer.outputs;
+        weights.cols = layer.inputs;
+        weights.stride = static_cast<uint32_t>(layer.stride);
+        weights.dtype = header.dtype;
+
+        TensorEntry& biases = description.tensors[2 * i + 1];
+        biases.offset = header.payload_offset + (layer.biases - base) * sizeof(float);
+        biases.bytes = layer.outputs * sizeof(float);
+        biases.rows = 1;
+        biases.cols = layer.outputs;
+        biases.stride = static_cast<uint32_t>(aligned_floats(layer.outputs));
+        biases.dtype = header.dtype;
+    }
+    return description;
+}
+
+void MLP::check_layout(const ModelDescription& description) const {
+    if (description.header.dtype != static_cast<uint32_t>(DType::F32) ||
+        description.header.activation != static_cast<uint32_t>(Activation::Sigmoid)) {
+        throw std::runtime_error("Model file uses an unsupported dtype or activation.");
+    }
+    const ModelDescription expected = describe();
+    if (description.header.payload_offset != expected.header.payload_offset ||
+        description.header.payload_bytes != expected.header.payload_bytes ||
+        description.tensors.size() != expected.tensors.size() ||
+        std::memcmp(description.tensors.data(), expected.tensors.data(), expected.tensors.size() * sizeof(TensorEntry)) != 0) {
+        throw std::runtime_error("Model file tensor layout does not match its topology.");
+    }
+}
+
+ModelDescription MLP::read_description(std::istream& file) {
+    file.seekg(0, std::ios::end);
+    const uint64_t file_size = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+
+    std::vector<unsigned char> bytes(sizeof(ModelHeader));
+    file.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+    if (!file || !has_model_magic(bytes.data(), bytes.size())) {
+        throw std::runtime_error("Not an MLP model file.");
+    }
+    ModelHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    const size_t header_bytes = model_header_bytes(header);
+    if (header_bytes > file_size) {
+        throw std::runtime_error("Truncated model file header.");
+    }
+    bytes.resize(header_bytes);
+    file.read(reinterpret_cast<char*>(bytes.data() + sizeof(ModelHeader)), header_bytes - sizeof(ModelHeader));
+    return parse_model_description(bytes.data(), file ? bytes.size() : 0, file_size);
+}
+
+void MLP::read_parameters(std::istream& file, const ModelDescription& description) {
+    check_layout(description);
+    float* payload = layer_views.front().weights;
+    file.seekg(description.header.payload_offset);
+    file.read(reinterpret_cast<char*>(payload), description.header.payload_bytes);
+    if (!file) {
+        throw std::runtime_error("Truncated model file payload.");
+    }
+    if (model_checksum(payload, description.header.payload_bytes) != description.header.checksum) {
+        throw std::runtime_error("Model file checksum mismatch.");
+    }
+}
+
+void MLP::activation_function(float* values, const float* biases, int count) const {
+    kernels::bias_sigmoid(values, biases, count); // Sigmoid function, applied in place
+}
+
+inline float MLP::activation_derivative(float x) const {
+    return x * (1.0f - x); // Derivative of the sigmoid function
+}
+
+const float* MLP::feedforward(const float* inputs, size_t input_stride, int count, Workspace& workspace) const {
+    workspace.reserve(layer_sizes, count); // Allocates only when the batch outgrows it
+    for (int b = 0; b < count; ++b) {
+        std::copy_n(inputs + b * input_stride, layer_sizes.front(), workspace.activations(0) + b * workspace.stride(0));
+    }
+    forward_rows(workspace, 0, count);
+    return workspace.activations(layer_sizes.size() - 1);
+}
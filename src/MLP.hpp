@@ -1,25 +1,217 @@
 #pragma once
 
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
+#include "Checkpoint.hpp"
+#include "Layer.hpp"
+#include "ModelFormat.hpp"
+#include "Optimizer.hpp"
+#include "Stats.hpp"
+#include "Workspace.hpp"
+
+class Dataset;
+class MappedFile;
+struct Batch;
+class ThreadPool;
+
+enum class Parallelism {
+  Synchronous, // Shard each mini-batch, all-reduce the gradients, one update
+  Hogwild      // Each thread pulls its own batches and runs SGD, updating shared weights without locks
+};
+
+struct TrainOptions {
+  int batch_size = 1; // Samples per step; gradients are averaged over the batch
+  int threads = 1;    // Worker threads; 0 uses every hardware thread
+  Parallelism parallelism = Parallelism::Synchronous;
+  int first_epoch = 0; // Epochs already done, from a resumed checkpoint; training runs [first_epoch, epochs)
+  // Checkpoints go to checkpoint_path every checkpoint_epochs epochs and/or at
+  // the first epoch end checkpoint_seconds after the previous one, and after
+  // the last epoch. They are written in the background; train returns once
+  // the last one is on disk.
+  std::string checkpoint_path;
+  int checkpoint_epochs = 0;
+  double checkpoint_seconds = 0.0;
+
+  float learning_rate = 0.0f; // Peak of the schedule; 0 uses the rate the model was built with
+  OptimizerOptions optimizer;
+  ScheduleOptions schedule;
+  // Early stopping watches the validation loss after every epoch, or the
+  // training loss without a validation set. Training stops once it has not
+  // beaten its best by more than min_delta for patience epochs, or as soon as
+  // it reaches target_loss. With a validation set the weights that scored
+  // best are restored at the end, before the final checkpoint, which keeps
+  // the last epoch's optimizer state. Checkpoints also save the best weights,
+  // so a resumed run restores the best of the whole run. The vector overloads
+  // hold out the last validation_fraction of the samples instead.
+  Dataset *validation = nullptr;
+  float validation_fraction = 0.0f;
+  int patience = 0;         // 0 never stops for lack of progress
+  float min_delta = 0.0f;
+  float target_loss = 0.0f; // 0 runs every epoch
+  int report_epochs = 100;  // Print the loss every this many epochs; 0 prints the last one only
+};
+
+// Magnitude pruning: each large layer is cut into block_rows x block_cols
+// tiles and the tiles with the smallest L1 norm are zeroed. 1x1 tiles prune
+// single weights; the other shapes are those of the block-sparse kernels.
+struct PruneOptions {
+  float sparsity = 0.9f; // Fraction of each pruned layer's tiles set to zero, in [0, 1)
+  int block_rows = 1;    // 1, 2, 4 or 8 (by 8 or 16 columns), or 1x1
+  int block_cols = 1;
+  std::size_t min_weights = 16384; // Layers with fewer weights stay dense
+};
+
 class MLP {
 public:
   MLP(const std::vector<int> &layers, float learning_rate);
+  // Builds the network described by a saved model file, copying its weights
+  static MLP from_file(const std::string &filename);
+  // Serves the weights straight from a private mapping of the file: nothing is
+  // copied at open, pages load on first touch and are shared with every other
+  // process mapping the same model. Checksum verification reads every page,
+  // so it is off by default.
+  static MLP open_mapped(const std::string &filename, bool verify_checksum = false);
+  // Loads a checkpoint written during train and its training state. Passing
+  // state.epoch as TrainOptions::first_epoch, with the same dataset seed and
+  // options, continues synchronous training bit for bit, early stopping and
+  // its best weights included. A pruned model comes back pruned, so its
+  // zeroed tiles stay zero.
+  static MLP resume(const std::string &checkpoint, TrainingState &state);
+  // Layer views point into the parameter buffer, so the model can move but not copy
+  MLP(const MLP &) = delete;
+  MLP &operator=(const MLP &) = delete;
+  MLP(MLP &&);
+  MLP &operator=(MLP &&);
+  ~MLP();
+
+  // Each step stacks batch_size samples and averages their gradients; a batch
+  // size of 1 is plain per-sample SGD
+  void train(const std::vector<std::vector<float>> &inputs,
+             const std::vector<std::vector<float>> &labels, int epochs,
+             int batch_size = 1);
   void train(const std::vector<std::vector<float>> &inputs,
-             const std::vector<std::vector<float>> &labels, int epochs);
+             const std::vector<std::vector<float>> &labels, int epochs,
+             const TrainOptions &options);
+  // Streams epochs from data, so the training set never has to fit in memory.
+  // epochs counts from the start of the run, resumed or not. A first_epoch of
+  // 0 starts afresh; otherwise the optimizer state and early-stopping
+  // progress of the previous call or resumed checkpoint carry on.
+  void train(Dataset &data, int epochs, const TrainOptions &options = {});
+  // Mean squared error per output of the network, without blending, over one
+  // pass of data
+  float evaluate(Dataset &data, int batch_size = 32);
   std::vector<float> predict(const std::vector<float> &input);
+  // Allocation-free inference into output, which must have the output layer
+  // size. With a caller-owned workspace predict is const, so threads can share
+  // one model as long as each uses its own workspace.
+  void predict(std::span<const float> input, std::span<float> output);
+  void predict(std::span<const float> input, std::span<float> output,
+               Workspace &workspace) const;
+  // Batched form for count samples: input rows input_stride floats apart,
+  // output rows output_stride floats apart. Sizes are not checked here.
+  void predict_batch(const float *inputs, std::size_t input_stride, float *outputs,
+                     std::size_t output_stride, int count, Workspace &workspace) const;
+  // Gathered form for samples in separate buffers, such as server requests:
+  // row b reads inputs[b] and writes outputs[b]. The inputs are copied into
+  // the workspace's input matrix first.
+  void predict_rows(std::span<const float *const> inputs, std::span<float *const> outputs,
+                    Workspace &workspace) const;
+  // Once pruned, the model is saved through SparseMLP, with every layer in
+  // whichever format multiplies faster on this machine, so loaders that run
+  // SparseMLP use the sparse kernels only where they beat dense
   void save_model(const std::string &filename);
+  // Loads weights into this network; throws if the file's topology differs.
+  // Headerless files from older builds are accepted when their size matches.
   void load_model(const std::string &filename);
 
+  // Zeroes the weakest tiles of every layer with at least min_weights weights.
+  // Training afterwards keeps them at zero, so fine-tuning is another train().
+  // Pruning again adds to the tiles already pruned.
+  void prune(const PruneOptions &options);
+  bool pruned() const { return !prune_mask.empty(); }
+  int pruned_block_rows() const { return prune_block_rows; }
+  int pruned_block_cols() const { return prune_block_cols; }
+
+  // Called on the training thread after every epoch; see EpochStats for what
+  // needs an MLP_STATS build
+  void set_stats_callback(StatsCallback callback) { stats_callback = std::move(callback); }
+
+  const std::vector<int> &topology() const { return layer_sizes; }
+  const std::vector<LayerView> &layers() const { return layer_views; }
+
 private:
-  inline float activation_function(float x);
-  inline float activation_derivative(float x);
-  float dot_product(const std::vector<float> &v1, const std::vector<float> &v2);
-  std::vector<float> feedforward(const std::vector<float> &input);
-
-  std::vector<std::vector<std::vector<float>>> weights;
-  std::vector<std::vector<float>> biases;
-  float learning_rate;
+  friend class SparseMLP; // Unpacks sparse model files into the parameter layout
+
+  MLP() = default;
+  void allocate(const std::vector<int> &layers);
+  ModelDescription describe() const;
+  void check_layout(const ModelDescription &description) const;
+  static ModelDescription read_description(std::istream &file);
+  void read_parameters(std::istream &file, const ModelDescription &description);
+
+  void stack_batch(Workspace &batch, const Batch &rows, int first, int count) const;
+  void forward_rows(Workspace &batch, int first, int count) const;
+  float backward_rows(Workspace &batch, int first, int count) const;
+  // target += alpha * gradient of rows [first, first + count), or target =
+  // alpha * gradient when overwrite is set. target has the parameter layout.
+  void accumulate_gradients(const Workspace &batch, int first, int count,
+                            float alpha, bool overwrite, float *target);
+  void layer_gradient(const Workspace &batch, std::size_t layer, int first, int count,
+                      float alpha, bool overwrite, float *target);
+  // Momentum and Adam: computes each layer's gradient of the first count rows
+  // into gradient (parameter layout) and updates that layer while it is in cache
+  void update_layers(const Workspace &batch, int count, float rate, float *gradient);
+  // Applies the optimizer to parameters [begin, end) from gradient, the sum
+  // over count samples, as update number step
+  void apply_update(std::size_t begin, std::size_t end, const float *gradient, float rate,
+                    int count, std::uint64_t step);
+  std::uint64_t next_optimizer_step();
+  // One epoch each at the given rate; return the summed squared error and add
+  // the samples seen to samples
+  float train_synchronous(Dataset &data, float rate, std::size_t &samples);
+  float train_hogwild(Dataset &data, float rate, std::size_t &samples);
+  ThreadPool &thread_pool(int threads);
+  // Re-zeroes pruned weights in [begin, end) of the parameter layout after an update
+  void apply_prune_mask(std::size_t begin, std::size_t end);
+  // Marks the all-zero block_rows x block_cols tiles of a layer as pruned,
+  // for files that keep the tile shape but not the mask
+  void mask_zero_tiles(std::size_t layer, int block_rows, int block_cols);
+
+  void activation_function(float *values, const float *biases, int count) const;
+  inline float activation_derivative(float x) const;
+  // Runs count samples through the network; the output matrix lives in the workspace
+  const float *feedforward(const float *inputs, std::size_t input_stride, int count,
+                           Workspace &workspace) const;
+  void blend_output(const float *result, const float *input, float *output) const;
+  void bind_layers(float *base);
+
+  std::vector<int> layer_sizes;
+  std::vector<LayerView> layer_views; // One view per weight layer into parameters
+  AlignedVector<float> parameters; // All weights and biases, one allocation
+  std::unique_ptr<MappedFile> mapping; // Holds the weights instead of parameters after open_mapped
+  std::size_t parameter_count = 0;
+  AlignedVector<unsigned char> prune_mask; // Parameter layout, 0 where pruned; empty until prune
+  int prune_block_rows = 1;
+  int prune_block_cols = 1;
+  std::vector<Workspace> training_workspaces; // One per Hogwild worker, else one shared by the batch
+  std::vector<AlignedVector<float>> gradients; // Per-thread gradients, parameter layout
+  OptimizerOptions optimizer; // Of the current run
+  AlignedVector<float> moments; // Optimizer state: optimizer_slots buffers in the parameter layout
+  std::uint64_t optimizer_step = 0; // Updates so far, for Adam's bias correction
+  float best_loss = 0.0f; // Early stopping progress, carried into resumed runs
+  std::uint32_t stale_epochs = 0;
+  AlignedVector<float> best_parameters; // Weights of the best validation epoch, empty without one
+  std::vector<float> worker_losses;
+  std::vector<std::size_t> worker_samples;
+  Workspace inference_workspace; // Backs the predict overloads without a workspace
+  std::unique_ptr<ThreadPool> pool; // Kept between train calls
+  StatsCallback stats_callback;
+  std::unique_ptr<stats::ModelCounters> counters; // MLP_STATS builds only
+  float learning_rate = 0.0f;
   float average_loss = 0.0f; // To track the average loss
 };
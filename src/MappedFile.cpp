@@ -0,0 +1,33 @@
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// MappedFile.cpp
+#include "MappedFile.hpp"
+
+MappedFile::MappedFile(const std::string& filename) {
+    int descriptor = open(filename.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::runtime_error("Could not open file " + filename + " for mapping.");
+    }
+    struct stat info;
+    if (fstat(descriptor, &info) != 0 || info.st_size == 0) {
+        close(descriptor);
+        throw std::runtime_error("Could not map empty or unreadable file " + filename + ".");
+    }
+    length = static_cast<std::size_t>(info.st_size);
+
+    // Writable but private: training a mapped model copies only the touched pages
+    void* address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+    close(descriptor); // The mapping keeps its own reference
+    if (address == MAP_FAILED) {
+        throw std::runtime_error("Could not map file " + filename + ".");
+    }
+    bytes = static_cast<unsigned char*>(address);
+}
+
+MappedFile::~MappedFile() {
+    munmap(bytes, length);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Private, copy-on-write mapping of a whole file. Pages are read lazily and
+// shared with every other process mapping the same file until written.
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &filename);
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  unsigned char *data() const { return bytes; }
+  std::size_t size() const { return length; }
+
+private:
+  unsigned char *bytes = nullptr;
+  std::size_t length = 0;
+};
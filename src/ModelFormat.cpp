@@ -0,0 +1,132 @@
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+
+// ModelFormat.cpp
+#include "ModelFormat.hpp"
+
+std::size_t ModelDescription::header_bytes() const {
+    return sizeof(ModelHeader) + layer_sizes.size() * sizeof(std::uint32_t) + tensors.size() * sizeof(TensorEntry);
+}
+
+std::uint64_t model_checksum(const void* data, std::size_t bytes) {
+    constexpr std::uint64_t prime = 0x100000001b3ull;
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    const unsigned char* cursor = static_cast<const unsigned char*>(data);
+    for (; bytes >= sizeof(std::uint64_t); bytes -= sizeof(std::uint64_t), cursor += sizeof(std::uint64_t)) {
+        std::uint64_t word;
+        std::memcpy(&word, cursor, sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+    for (; bytes > 0; --bytes, ++cursor) {
+        hash = (hash ^ *cursor) * prime;
+    }
+    return hash;
+}
+
+bool has_model_magic(const unsigned char* data, std::size_t available) {
+    return available >= sizeof(kModelMagic) && std::memcmp(data, kModelMagic, sizeof(kModelMagic)) == 0;
+}
+
+ModelHeader read_model_header(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file to load model.");
+    }
+    ModelHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || !has_model_magic(reinterpret_cast<const unsigned char*>(header.magic), sizeof(header.magic))) {
+        throw std::runtime_error("Not an MLP model file.");
+    }
+    return header;
+}
+
+std::size_t dtype_size(DType dtype) {
+    switch (dtype) {
+    case DType::I8:
+        return 1;
+    case DType::BF16:
+    case DType::F16:
+        return 2;
+    case DType::F32:
+    case DType::I32:
+        break;
+    }
+    return 4;
+}
+
+const char* dtype_name(DType dtype) {
+    switch (dtype) {
+    case DType::I8:
+        return "int8";
+    case DType::BF16:
+        return "bf16";
+    case DType::F16:
+        return "f16";
+    case DType::I32:
+        return "int32";
+    case DType::F32:
+        break;
+    }
+    return "f32";
+}
+
+std::size_t model_header_bytes(const ModelHeader& header) {
+    return sizeof(ModelHeader) + static_cast<std::size_t>(header.layer_count) * sizeof(std::uint32_t) +
+           static_cast<std::size_t>(header.tensor_count) * sizeof(TensorEntry);
+}
+
+ModelDescription parse_model_description(const unsigned char* data, std::size_t available, std::uint64_t file_size) {
+    ModelDescription description;
+    if (available < sizeof(ModelHeader) || !has_model_magic(data, available)) {
+        throw std::runtime_error("Not an MLP model file.");
+    }
+    std::memcpy(&description.header, data, sizeof(ModelHeader));
+    const ModelHeader& header = description.header;
+    if (header.version == 0 || header.version > kSparseModelVersion) {
+        throw std::runtime_error("Unsupported model file version.");
+    }
+    if (header.layer_count < 2 || header.layer_count > 4096 || header.tensor_count > 8192) {
+        throw std::runtime_error("Corrupt model file header.");
+    }
+    if (available < model_header_bytes(header)) {
+        throw std::runtime_error("Truncated model file header.");
+    }
+
+    const unsigned char* cursor = data + sizeof(ModelHeader);
+    for (std::uint32_t i = 0; i < header.layer_count; ++i, cursor += sizeof(std::uint32_t)) {
+        std::uint32_t size;
+        std::memcpy(&size, cursor, sizeof(size));
+        if (size == 0 || size > (1u << 30)) {
+            throw std::runtime_error("Corrupt layer size in model file.");
+        }
+        description.layer_sizes.push_back(static_cast<int>(size));
+    }
+    description.tensors.resize(header.tensor_count);
+    std::memcpy(description.tensors.data(), cursor, header.tensor_count * sizeof(TensorEntry));
+
+    if (header.payload_offset % kTensorAlignment != 0 || header.payload_offset < description.header_bytes() ||
+        header.payload_offset + header.payload_bytes > file_size) {
+        throw std::runtime_error("Model payload lies outside the file.");
+    }
+    for (const TensorEntry& tensor : description.tensors) {
+        if (tensor.offset % kTensorAlignment != 0 || tensor.offset < header.payload_offset ||
+            tensor.offset + tensor.bytes > header.payload_offset + header.payload_bytes) {
+            throw std::runtime_error("Model tensor lies outside the payload.");
+        }
+    }
+    return description;
+}
+
+void write_model_description(std::ostream& out, const ModelDescription& description) {
+    out.write(reinterpret_cast<const char*>(&description.header), sizeof(ModelHeader));
+    for (int size : description.layer_sizes) {
+        const std::uint32_t value = static_cast<std::uint32_t>(size);
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    out.write(reinterpret_cast<const char*>(description.tensors.data()), description.tensors.size() * sizeof(TensorEntry));
+
+    static const char padding[kTensorAlignment] = {};
+    out.write(padding, description.header.payload_offset - description.header_bytes());
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Self-describing model container, little-endian:
+//   ModelHeader | uint32 layer sizes | TensorEntry table | padding | payload
+// Every tensor starts on a 64-byte boundary, so a memory-mapped file can be
+// used in place. The checksum covers the payload bytes.
+// Version 2 files start the tensor table with an I32 layer format table and
+// may store layers block-sparse (see SparseMLP); dense models stay version 1.
+constexpr char kModelMagic[8] = {'M', 'L', 'P', 'M', 'O', 'D', 'E', 'L'};
+constexpr std::uint32_t kModelVersion = 1;
+constexpr std::uint32_t kSparseModelVersion = 2;
+constexpr std::size_t kTensorAlignment = 64;
+
+// I8 weights are symmetric per row and come with an F32 scale tensor; I32
+// tensors hold sparse indices
+enum class DType : std::uint32_t { F32 = 0, I8 = 1, BF16 = 2, F16 = 3, I32 = 4 };
+enum class Activation : std::uint32_t { Sigmoid = 0 };
+
+struct ModelHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t dtype;      // DType of the weight tensors
+  std::uint32_t activation; // Activation used by every layer
+  std::uint32_t layer_count;  // Entries in the layer size list, input layer included
+  std::uint32_t tensor_count; // Entries in the tensor table
+  float learning_rate;
+  std::uint64_t payload_offset; // First byte covered by the checksum
+  std::uint64_t payload_bytes;
+  std::uint64_t checksum;
+};
+
+struct TensorEntry {
+  std::uint64_t offset; // From the start of the file, 64-byte aligned
+  std::uint64_t bytes;
+  std::uint32_t rows;
+  std::uint32_t cols;
+  std::uint32_t stride; // Elements between row starts
+  std::uint32_t dtype;
+};
+
+static_assert(sizeof(ModelHeader) == 56 && sizeof(TensorEntry) == 32, "Model file structs must not change size");
+
+struct ModelDescription {
+  ModelHeader header{};
+  std::vector<int> layer_sizes;
+  std::vector<TensorEntry> tensors;
+
+  std::size_t header_bytes() const;
+};
+
+// FNV-1a over 64-bit words (then the tail bytes); fast enough to run over
+// hundreds of megabytes at load time
+std::uint64_t model_checksum(const void *data, std::size_t bytes);
+
+// Bytes needed to parse a description whose fixed header is at data
+std::size_t model_header_bytes(const ModelHeader &header);
+// Validates magic, version, sizes and tensor bounds against the file size;
+// throws std::runtime_error on a malformed or unsupported file
+ModelDescription parse_model_description(const unsigned char *data, std::size_t available,
+                                         std::uint64_t file_size);
+bool has_model_magic(const unsigned char *data, std::size_t available);
+// Reads the fixed header only, to pick a loader before opening the model
+ModelHeader read_model_header(const std::string &filename);
+
+std::size_t dtype_size(DType dtype);
+const char *dtype_name(DType dtype);
+
+// Writes the header, size list and tensor table, padded to payload_offset
+void write_model_description(std::ostream &out, const ModelDescription &description);
+
+inline std::uint64_t align_offset(std::uint64_t offset) {
+  return (offset + kTensorAlignment - 1) / kTensorAlignment * kTensorAlignment;
+}
@@ -0,0 +1,55 @@
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+
+// Optimizer.cpp
+#include "Optimizer.hpp"
+
+int optimizer_slots(Optimizer kind) {
+    switch (kind) {
+    case Optimizer::SGD:
+        return 0;
+    case Optimizer::Momentum:
+        return 1; // Velocity
+    case Optimizer::Adam:
+        return 2; // First and second moments
+    }
+    throw std::invalid_argument("Unknown optimizer.");
+}
+
+const char* optimizer_name(Optimizer kind) {
+    switch (kind) {
+    case Optimizer::SGD:
+        return "sgd";
+    case Optimizer::Momentum:
+        return "momentum";
+    case Optimizer::Adam:
+        return "adam";
+    }
+    return "unknown";
+}
+
+float scheduled_learning_rate(const ScheduleOptions& schedule, float peak, int epoch, int epochs) {
+    if (schedule.warmup_epochs < 0 || (schedule.kind == Schedule::Step && schedule.step_epochs < 1)) {
+        throw std::invalid_argument("Warmup cannot be negative and steps need at least one epoch.");
+    }
+    if (epoch < schedule.warmup_epochs) {
+        return peak * static_cast<float>(epoch + 1) / static_cast<float>(schedule.warmup_epochs);
+    }
+
+    const int elapsed = epoch - schedule.warmup_epochs;
+    switch (schedule.kind) {
+    case Schedule::Constant:
+        return peak;
+    case Schedule::Step:
+        return peak * std::pow(schedule.step_factor, static_cast<float>(elapsed / schedule.step_epochs));
+    case Schedule::Cosine: {
+        const int span = std::max(1, epochs - schedule.warmup_epochs - 1);
+        const double progress = std::min(1.0, static_cast<double>(elapsed) / span);
+        const double factor = schedule.min_factor + (1.0 - schedule.min_factor) * 0.5 * (1.0 + std::cos(std::numbers::pi * progress));
+        return static_cast<float>(peak * factor);
+    }
+    }
+    return peak;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+// How train turns each mini-batch gradient into a weight update. Optimizer
+// state lives in the parameter layout, one buffer per slot, so every update
+// is a single fused pass over weights, gradient and moments.
+enum class Optimizer : std::uint32_t {
+  SGD = 0,      // w -= rate * g
+  Momentum = 1, // v = momentum * v + g; w -= rate * v
+  Adam = 2      // Bias-corrected first and second moments
+};
+
+struct OptimizerOptions {
+  Optimizer kind = Optimizer::SGD;
+  float momentum = 0.9f; // Momentum, and Adam's beta1
+  float beta2 = 0.999f;  // Adam only
+  float epsilon = 1e-8f; // Adam only
+};
+
+// Moment buffers of parameter size that the optimizer keeps
+int optimizer_slots(Optimizer kind);
+const char *optimizer_name(Optimizer kind);
+
+enum class Schedule {
+  Constant,
+  Step,  // Multiplied by step_factor every step_epochs
+  Cosine // Half cosine from the peak down to min_factor * peak at the last epoch
+};
+
+// Learning rate per epoch: a linear ramp up to the peak over warmup_epochs,
+// then the schedule over the remaining epochs
+struct ScheduleOptions {
+  Schedule kind = Schedule::Constant;
+  int warmup_epochs = 0;
+  int step_epochs = 10;
+  float step_factor = 0.5f;
+  float min_factor = 0.0f; // Cosine floor, as a fraction of the peak
+};
+
+// Rate for 0-based epoch out of epochs; throws std::invalid_argument for bad options
+float scheduled_learning_rate(const ScheduleOptions &schedule, float peak, int epoch, int epochs);
@@ -1,41 +1,210 @@
-#include "Perceptron.hpp"
+#include <algorithm>
 #include <cstdlib>
-#include <numeric>
+#include <stdexcept>
+#include <thread>
 
-Perceptron::Perceptron(int input_size, float learning_rate)
-    : learning_rate(learning_rate), bias(0.0f) {
-    weights.resize(input_size);
-    for (auto& weight : weights) {
-        weight = static_cast<float>(rand()) / RAND_MAX; // Initialize weights randomly
+// Perceptron.cpp
+#include "Perceptron.hpp"
+#include "Kernels.hpp"
+#include "ThreadPool.hpp"
+
+namespace {
+
+// Rows scored per matrix-vector call in Perceptron::predict_many
+constexpr std::size_t kScoreBlock = 256;
+
+float activation_function(float x) {
+    return x >= 0.0f ? 1.0f : 0.0f;
+}
+
+void check_labels(const SampleMatrix& samples, std::span<const int> labels, int input_size) {
+    if (samples.features() != input_size) {
+        throw std::invalid_argument("Sample size does not match the perceptron input size.");
+    }
+    if (labels.size() != samples.rows()) {
+        throw std::invalid_argument("There must be one label per sample.");
     }
 }
 
-void Perceptron::train(const std::vector<std::vector<float>>& inputs, const std::vector<int>& labels, int epochs) {
+// Trains one binary problem in place, where samples labelled positive are the
+// positive class. weights has the padded row layout of samples.
+void train_binary(const SampleMatrix& samples, std::span<const int> labels, int positive, int epochs,
+                  bool averaged, float learning_rate, float* weights, float& bias) {
+    const std::size_t n = samples.stride();
+    // Averaged perceptron: the sum of every update scaled by the step it was
+    // made at gives the mean of the weights over all steps as w - sum / steps
+    AlignedVector<float> weighted_updates(averaged ? n : 0, 0.0f);
+    float weighted_bias = 0.0f;
+    double step = 1.0;
+
     for (int epoch = 0; epoch < epochs; ++epoch) {
-        for (size_t i = 0; i < inputs.size(); ++i) {
-            std::vector<float> input = inputs[i];
-            int label = labels[i];
-            float prediction = activation_function(dot_product(input, weights) + bias);
-            float error = label - prediction;
+        for (std::size_t i = 0; i < samples.rows(); ++i, step += 1.0) {
+            const float* input = samples.row(i);
+            const float label = labels[i] == positive ? 1.0f : 0.0f;
+            const float prediction = activation_function(kernels::dot(input, weights, n) + bias);
+            const float error = label - prediction;
+            if (error == 0.0f) {
+                continue;
+            }
 
             // Update weights and bias
-            for (size_t j = 0; j < weights.size(); ++j) {
-                weights[j] += learning_rate * error * input[j];
-            }
+            kernels::axpy(learning_rate * error, input, weights, n);
             bias += learning_rate * error;
+            if (averaged) {
+                const float scaled = static_cast<float>(learning_rate * error * step);
+                kernels::axpy(scaled, input, weighted_updates.data(), n);
+                weighted_bias += scaled;
+            }
         }
     }
+
+    if (averaged) {
+        kernels::axpy(static_cast<float>(-1.0 / step), weighted_updates.data(), weights, n);
+        bias -= static_cast<float>(weighted_bias / step);
+    }
+}
+
+} // namespace
+
+SampleMatrix::SampleMatrix(std::size_t rows, int features)
+    : row_count(rows), feature_count(features), row_stride(aligned_floats(features)) {
+    if (features <= 0) {
+        throw std::invalid_argument("Samples must have at least one feature.");
+    }
+    values.assign(rows * row_stride, 0.0f);
+}
+
+SampleMatrix::SampleMatrix(const std::vector<std::vector<float>>& rows)
+    : SampleMatrix(rows.size(), rows.empty() ? 1 : static_cast<int>(rows.front().size())) {
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        if (rows[i].size() != static_cast<std::size_t>(feature_count)) {
+            throw std::invalid_argument("Every sample must have the same size.");
+        }
+        std::copy(rows[i].begin(), rows[i].end(), row(i));
+    }
+}
+
+Perceptron::Perceptron(int input_size, float learning_rate)
+    : inputs(input_size), learning_rate(learning_rate), bias(0.0f) {
+    if (input_size <= 0) {
+        throw std::invalid_argument("Input size must be greater than zero.");
+    }
+    weights.assign(aligned_floats(input_size), 0.0f);
+    for (int i = 0; i < input_size; ++i) {
+        weights[i] = static_cast<float>(rand()) / RAND_MAX; // Initialize weights randomly
+    }
+}
+
+void Perceptron::train(const std::vector<std::vector<float>>& inputs, const std::vector<int>& labels, int epochs) {
+    if (inputs.empty()) {
+        return; // Nothing to learn, and no rows to take the feature count from
+    }
+    train(SampleMatrix(inputs), labels, epochs);
+}
+
+void Perceptron::train(const SampleMatrix& samples, std::span<const int> labels, int epochs,
+                       const PerceptronOptions& options) {
+    check_labels(samples, labels, inputs);
+    train_binary(samples, labels, 1, epochs, options.averaged, learning_rate, weights.data(), bias);
 }
 
 std::vector<float> Perceptron::predict(const std::vector<float>& input) {
-    float sum = dot_product(input, weights) + bias;
-    return {activation_function(sum)};
+    return {static_cast<float>(classify(input))};
 }
 
-float Perceptron::activation_function(float x) {
-    return x >= 0.0f ? 1.0f : 0.0f;
+int Perceptron::classify(std::span<const float> input) const {
+    if (input.size() != static_cast<std::size_t>(inputs)) {
+        throw std::invalid_argument("Input size does not match the perceptron input size.");
+    }
+    return static_cast<int>(activation_function(kernels::dot(input.data(), weights.data(), inputs) + bias));
+}
+
+void Perceptron::predict_many(const SampleMatrix& samples, std::span<int> classes) const {
+    if (samples.features() != inputs || classes.size() < samples.rows()) {
+        throw std::invalid_argument("Samples or output do not match the perceptron.");
+    }
+    float scores[kScoreBlock];
+    for (std::size_t first = 0; first < samples.rows(); first += kScoreBlock) {
+        const std::size_t count = std::min(kScoreBlock, samples.rows() - first);
+        kernels::dot_rows(samples.row(first), samples.stride(), weights.data(), samples.stride(), count, scores);
+        for (std::size_t b = 0; b < count; ++b) {
+            classes[first + b] = static_cast<int>(activation_function(scores[b] + bias));
+        }
+    }
+}
+
+OneVsRest::OneVsRest(int input_size, int classes, float learning_rate)
+    : inputs(input_size), class_count(classes), learning_rate(learning_rate), stride(aligned_floats(input_size)) {
+    if (input_size <= 0 || classes < 2) {
+        throw std::invalid_argument("One-vs-rest needs at least one input and two classes.");
+    }
+    weights.assign(classes * stride, 0.0f);
+    biases.assign(classes, 0.0f);
+    for (int c = 0; c < classes; ++c) {
+        for (int i = 0; i < input_size; ++i) {
+            weights[c * stride + i] = static_cast<float>(rand()) / RAND_MAX; // Initialize weights randomly
+        }
+    }
+}
+
+OneVsRest::OneVsRest(OneVsRest&&) = default;
+OneVsRest& OneVsRest::operator=(OneVsRest&&) = default;
+OneVsRest::~OneVsRest() = default;
+
+void OneVsRest::train(const SampleMatrix& samples, std::span<const int> labels, int epochs,
+                      const PerceptronOptions& options) {
+    check_labels(samples, labels, inputs);
+    int threads = options.threads;
+    if (threads < 1) {
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    threads = std::min(threads, class_count); // Classes are the unit of work
+    if (!pool || pool->size() != threads) {
+        pool = std::make_unique<ThreadPool>(threads);
+    }
+
+    // Every worker streams the whole shared sample matrix for each of its
+    // classes; weight rows are cache-line aligned, so workers never share a line
+    pool->run([&](int worker) {
+        for (int c = worker; c < class_count; c += threads) {
+            float bias = biases[c];
+            train_binary(samples, labels, c, epochs, options.averaged, learning_rate, weights.data() + c * stride, bias);
+            biases[c] = bias;
+        }
+    });
+}
+
+int OneVsRest::classify(std::span<const float> input) const {
+    if (input.size() != static_cast<std::size_t>(inputs)) {
+        throw std::invalid_argument("Input size does not match the classifier input size.");
+    }
+    int best = 0;
+    float best_score = 0.0f;
+    for (int c = 0; c < class_count; ++c) {
+        const float score = kernels::dot(input.data(), weights.data() + c * stride, inputs) + biases[c];
+        if (c == 0 || score > best_score) {
+            best = c;
+            best_score = score;
+        }
+    }
+    return best;
 }
 
-float Perceptron::dot_product(const std::vector<float>& v1, const std::vector<float>& v2) {
-    return std::inner_product(v1.begin(), v1.end(), v2.begin(), 0.0f);
-}
\ No newline at end of file
+void OneVsRest::predict_many(const SampleMatrix& samples, std::span<int> classes) const {
+    if (samples.features() != inputs || classes.size() < samples.rows()) {
+        throw std::invalid_argument("Samples or output do not match the classifier.");
+    }
+    // The weight matrix stays in L1, so each row is scored against every class
+    // in one pass that reads the row once per four classes
+    std::vector<float> scores(class_count);
+    for (std::size_t i = 0; i < samples.rows(); ++i) {
+        kernels::dot_rows(weights.data(), stride, samples.row(i), samples.stride(), class_count, scores.data());
+        int best = 0;
+        for (int c = 1; c < class_count; ++c) {
+            if (scores[c] + biases[c] > scores[best] + biases[best]) {
+                best = c;
+            }
+        }
+        classes[i] = best;
+    }
+}
@@ -1,18 +1,93 @@
 #pragma once
 
+#include <cstddef>
+#include <memory>
+#include <span>
 #include <vector>
 
+#include "Layer.hpp"
+
+class ThreadPool;
+
+// Row-major samples in one allocation. Rows start on a cache line and their
+// padding is zero, so kernels can run over whole padded rows.
+class SampleMatrix {
+public:
+  SampleMatrix() = default;
+  SampleMatrix(std::size_t rows, int features);
+  // Copies nested vectors, which must all have the same size
+  explicit SampleMatrix(const std::vector<std::vector<float>> &rows);
+
+  std::size_t rows() const { return row_count; }
+  int features() const { return feature_count; }
+  std::size_t stride() const { return row_stride; }
+  float *row(std::size_t index) { return values.data() + index * row_stride; }
+  const float *row(std::size_t index) const { return values.data() + index * row_stride; }
+
+private:
+  std::size_t row_count = 0;
+  int feature_count = 0;
+  std::size_t row_stride = 0;
+  AlignedVector<float> values;
+};
+
+struct PerceptronOptions {
+  bool averaged = false; // Keep the average of the weights over every step instead of the last ones
+  int threads = 1;       // Workers for one-vs-rest training; 0 uses every hardware thread
+};
+
+// Binary linear classifier with mistake-driven updates: labels are 0 or 1 and
+// a sample is positive when w.x + b >= 0
 class Perceptron {
 public:
-    Perceptron(int input_size, float learning_rate);
-    void train(const std::vector<std::vector<float>>& inputs, const std::vector<int>& labels, int epochs);
-    std::vector<float> predict(const std::vector<float>& input);
+  Perceptron(int input_size, float learning_rate);
+  void train(const std::vector<std::vector<float>> &inputs, const std::vector<int> &labels, int epochs);
+  // Runs over the samples in order; every update reads the row in place
+  void train(const SampleMatrix &samples, std::span<const int> labels, int epochs,
+             const PerceptronOptions &options = {});
+  std::vector<float> predict(const std::vector<float> &input);
+  // Allocation-free form of predict: 1 or 0
+  int classify(std::span<const float> input) const;
+  // Classifies blocks of rows with the vector matrix-vector kernel; classes
+  // needs one entry per row
+  void predict_many(const SampleMatrix &samples, std::span<int> classes) const;
+
+  int input_size() const { return inputs; }
+  std::span<const float> weight_values() const { return {weights.data(), static_cast<std::size_t>(inputs)}; }
+  float bias_value() const { return bias; }
 
 private:
-    std::vector<float> weights;
-    float learning_rate;
-    float bias;
+  int inputs;
+  float learning_rate;
+  float bias;
+  AlignedVector<float> weights; // Padded to a cache line with zeros, like a sample row
+};
+
+// K perceptrons, one per class, each trained against the rest; a sample gets
+// the class with the highest score. The classes train in parallel, and batched
+// prediction scores each row against every class with one matrix-vector call.
+class OneVsRest {
+public:
+  OneVsRest(int input_size, int classes, float learning_rate);
+  OneVsRest(OneVsRest &&);
+  OneVsRest &operator=(OneVsRest &&);
+  ~OneVsRest();
+
+  // Labels are class indices in [0, classes)
+  void train(const SampleMatrix &samples, std::span<const int> labels, int epochs,
+             const PerceptronOptions &options = {});
+  int classify(std::span<const float> input) const;
+  void predict_many(const SampleMatrix &samples, std::span<int> classes) const;
 
-    float activation_function(float x);
-    float dot_product(const std::vector<float>& v1, const std::vector<float>& v2);
+  int input_size() const { return inputs; }
+  int classes() const { return class_count; }
+
+private:
+  int inputs;
+  int class_count;
+  float learning_rate;
+  std::size_t stride; // Floats between two classes' weight rows
+  AlignedVector<float> weights; // [classes x stride]
+  std::vector<float> biases;
+  std::unique_ptr<ThreadPool> pool; // Kept between train calls
 };
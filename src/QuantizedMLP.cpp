@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+// QuantizedMLP.cpp
+#include "QuantizedMLP.hpp"
+#include "Kernels.hpp"
+#include "MLP.hpp"
+#include "MappedFile.hpp"
+
+namespace {
+
+// Activations in [0, 1] map to 0..127: the largest u8 x s8 pair sum,
+// 2 * 127 * 127, still fits the int16 lanes of the AVX2 kernel
+constexpr float kActivationLevels = 127.0f;
+
+bool is_quantized(DType dtype) {
+    return dtype == DType::I8 || dtype == DType::BF16 || dtype == DType::F16;
+}
+
+} // namespace
+
+QuantizedMLP::QuantizedMLP(const MLP& model, DType dtype) : weight_type(dtype), layer_sizes(model.topology()) {
+    if (!is_quantized(dtype)) {
+        throw std::invalid_argument("Quantized models need int8, bf16 or f16 weights.");
+    }
+
+    const ModelDescription description = describe();
+    payload_size = description.header.payload_bytes;
+    storage.assign(payload_size, 0); // Zero padding, which the int8 kernel reads
+    bind_layers(storage.data(), description);
+
+    // The views are read-only, so write through the same offsets into storage
+    auto writable = [&](const void* tensor) { return storage.data() + (static_cast<const unsigned char*>(tensor) - payload); };
+    const std::vector<LayerView>& source = model.layers();
+    for (size_t i = 0; i < layer_views.size(); ++i) {
+        const LayerView& from = source[i];
+        const QuantizedLayer& to = layer_views[i];
+        unsigned char* weights = writable(to.weights);
+        for (int j = 0; j < from.outputs; ++j) {
+            const float* row = from.row(j);
+            if (dtype == DType::I8) {
+                // Symmetric per-row scale: the largest weight maps to 127
+                float largest = 0.0f;
+                for (int k = 0; k < from.inputs; ++k) {
+                    largest = std::max(largest, std::fabs(row[k]));
+                }
+                const float scale = largest / 127.0f;
+                reinterpret_cast<float*>(writable(to.scales))[j] = scale;
+                std::int8_t* out = reinterpret_cast<std::int8_t*>(weights) + j * to.stride;
+                for (int k = 0; k < from.inputs; ++k) {
+                    out[k] = scale > 0.0f ? static_cast<std::int8_t>(std::lround(row[k] / scale)) : 0;
+                }
+            } else {
+                std::uint16_t* out = reinterpret_cast<std::uint16_t*>(weights) + j * to.stride;
+                for (int k = 0; k < from.inputs; ++k) {
+                    out[k] = dtype == DType::BF16 ? kernels::float_to_bf16(row[k]) : kernels::float_to_f16(row[k]);
+                }
+            }
+        }
+        std::copy_n(from.biases, from.outputs, reinterpret_cast<float*>(writable(to.biases)));
+    }
+}
+
+QuantizedMLP QuantizedMLP::open_mapped(const std::string& filename, bool verify_checksum) {
+    auto mapping = std::make_unique<MappedFile>(filename);
+    ModelDescription description = parse_model_description(mapping->data(), mapping->size(), mapping->size());
+
+    QuantizedMLP model;
+    model.weight_type = static_cast<DType>(description.header.dtype);
+    model.layer_sizes = description.layer_sizes;
+    if (!is_quantized(model.weight_type) || description.header.activation != static_cast<uint32_t>(Activation::Sigmoid)) {
+        throw std::runtime_error("Model file is not a quantized sigmoid network.");
+    }
+    const ModelDescription expected = model.describe();
+    if (description.header.payload_offset != expected.header.payload_offset ||
+        description.header.payload_bytes != expected.header.payload_bytes ||
+        description.tensors.size() != expected.tensors.size() ||
+        std::memcmp(description.tensors.data(), expected.tensors.data(), expected.tensors.size() * sizeof(TensorEntry)) != 0) {
+        throw std::runtime_error("Model file tensor layout does not match its topology.");
+    }
+    const unsigned char* payload = mapping->data() + description.header.payload_offset;
+    if (verify_checksum && model_checksum(payload, description.header.payload_bytes) != description.header.checksum) {
+        throw std::runtime_error("Model file checksum mismatch.");
+    }
+    model.payload_size = description.header.payload_bytes;
+    model.bind_layers(payload, description);
+    model.mapping = std::move(mapping);
+    return model;
+}
+
+QuantizedMLP::QuantizedMLP(QuantizedMLP&&) = default;
+QuantizedMLP& QuantizedMLP::operator=(QuantizedMLP&&) = default;
+QuantizedMLP::~QuantizedMLP() = default;
+
+ModelDescription QuantizedMLP::describe() const {
+    ModelDescription description;
+    ModelHeader& header = description.header;
+    std::memcpy(header.magic, kModelMagic, sizeof(kModelMagic));
+    header.version = kModelVersion;
+    header.dtype = static_cast<uint32_t>(weight_type);
+    header.activation = static_cast<uint32_t>(Activation::Sigmoid);
+    header.layer_count = static_cast<uint32_t>(layer_sizes.size());
+    const uint32_t per_layer = weight_type == DType::I8 ? 3 : 2;
+    header.tensor_count = per_layer * static_cast<uint32_t>(layer_sizes.size() - 1);
+    description.layer_sizes = layer_sizes;
+    description.tensors.resize(header.tensor_count);
+    header.payload_offset = align_offset(description.header_bytes());
+
+    // Per layer: weights, biases, then the int8 scales, each on a 64-byte boundary
+    const size_t element = dtype_size(weight_type);
+    uint64_t offset = header.payload_offset;
+    auto place = [&](TensorEntry& tensor, uint32_t rows, uint32_t cols, size_t element_bytes, DType dtype) {
+        tensor.offset = offset;
+        tensor.rows = rows;
+        tensor.cols = cols;
+        tensor.stride = static_cast<uint32_t>(align_offset(cols * element_bytes) / element_bytes);
+        tensor.bytes = static_cast<uint64_t>(rows) * tensor.stride * element_bytes;
+        tensor.dtype = static_cast<uint32_t>(dtype);
+        offset = align_offset(offset + tensor.bytes);
+    };
+    for (size_t i = 1; i < layer_sizes.size(); ++i) {
+        TensorEntry* tensors = description.tensors.data() + per_layer * (i - 1);
+        place(tensors[0], layer_sizes[i], layer_sizes[i - 1], element, weight_type);
+        place(tensors[1], 1, layer_sizes[i], sizeof(float), DType::F32);
+        if (weight_type == DType::I8) {
+            place(tensors[2], 1, layer_sizes[i], sizeof(float), DType::F32);
+        }
+    }
+    header.payload_bytes = offset - header.payload_offset;
+    return description;
+}
+
+void QuantizedMLP::bind_layers(const unsigned char* base, const ModelDescription& description) {
+    payload = base;
+    const uint64_t origin = description.header.payload_offset;
+    const size_t per_layer = weight_type == DType::I8 ? 3 : 2;
+    layer_views.clear();
+    for (size_t i = 1; i < layer_sizes.size(); ++i) {
+        const TensorEntry* tensors = description.tensors.data() + per_layer * (i - 1);
+        QuantizedLayer layer;
+        layer.inputs = layer_sizes[i - 1];
+        layer.outputs = layer_sizes[i];
+        layer.stride = tensors[0].stride;
+        layer.weights = base + (tensors[0].offset - origin);
+        layer.biases = reinterpret_cast<const float*>(base + (tensors[1].offset - origin));
+        if (weight_type == DType::I8) {
+            layer.scales = reinterpret_cast<const float*>(base + (tensors[2].offset - origin));
+        }
+        layer_views.push_back(layer);
+    }
+}
+
+void QuantizedMLP::predict(std::span<const float> input, std::span<float> output) {
+    if (input.size() != static_cast<size_t>(layer_sizes.front())) {
+        throw std::invalid_argument("Input size does not match the input layer size.");
+    }
+    if (output.size() != static_cast<size_t>(layer_sizes.back())) {
+        throw std::invalid_argument("Output size does not match the output layer size.");
+    }
+    predict_batch(input.data(), input.size(), output.data(), output.size(), 1);
+}
+
+void QuantizedMLP::predict_batch(const float* inputs, size_t input_stride, float* outputs, size_t output_stride, int count) {
+    // Hidden activations alternate between two scratch matrices; only grows
+    const size_t stride = aligned_floats(*std::max_element(layer_sizes.begin(), layer_sizes.end()));
+    for (AlignedVector<float>& buffer : scratch) {
+        if (buffer.size() < count * stride) {
+            buffer.resize(count * stride);
+        }
+    }
+
+    const float* in = inputs;
+    size_t in_stride = input_stride;
+    for (size_t i = 0; i < layer_views.size(); ++i) {
+        const bool last = i + 1 == layer_views.size();
+        float* out = last ? outputs : scratch[i % 2].data();
+        const size_t out_stride = last ? output_stride : stride;
+        run_layer(layer_views[i], in, in_stride, out, out_stride, count);
+        in = out;
+        in_stride = out_stride;
+    }
+}
+
+void QuantizedMLP::run_layer(const QuantizedLayer& layer, const float* in, size_t in_stride,
+                             float* out, size_t out_stride, int count) {
+    // Rows outer, samples inner, so each weight row is read from memory once per batch
+    if (weight_type == DType::I8) {
+        if (quantized.size() < count * layer.stride) {
+            quantized.resize(count * layer.stride);
+        }
+        for (int b = 0; b < count; ++b) {
+            const float* row = in + b * in_stride;
+            std::uint8_t* q = quantized.data() + b * layer.stride;
+            for (int k = 0; k < layer.inputs; ++k) {
+                q[k] = static_cast<std::uint8_t>(std::clamp(row[k], 0.0f, 1.0f) * kActivationLevels + 0.5f);
+            }
+            std::fill(q + layer.inputs, q + layer.stride, std::uint8_t{0});
+        }
+        const std::int8_t* weights = static_cast<const std::int8_t*>(layer.weights);
+        for (int j = 0; j < layer.outputs; ++j) {
+            const float scale = layer.scales[j] / kActivationLevels;
+            for (int b = 0; b < count; ++b) {
+                const std::int32_t sum = kernels::dot_u8s8(quantized.data() + b * layer.stride, weights + j * layer.stride, layer.stride);
+                out[b * out_stride + j] = static_cast<float>(sum) * scale;
+            }
+        }
+    } else {
+        const std::uint16_t* weights = static_cast<const std::uint16_t*>(layer.weights);
+        const bool bf16 = weight_type == DType::BF16;
+        for (int j = 0; j < layer.outputs; ++j) {
+            const std::uint16_t* row = weights + j * layer.stride;
+            for (int b = 0; b < count; ++b) {
+                out[b * out_stride + j] = bf16 ? kernels::dot_bf16(in + b * in_stride, row, layer.inputs)
+                                               : kernels::dot_f16(in + b * in_stride, row, layer.inputs);
+            }
+        }
+    }
+    for (int b = 0; b < count; ++b) {
+        kernels::bias_sigmoid(out + b * out_stride, layer.biases, layer.outputs);
+    }
+}
+
+void QuantizedMLP::save_model(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file to save model.");
+    }
+
+    ModelDescription description = describe();
+    description.header.checksum = model_checksum(payload, payload_size);
+    write_model_description(file, description);
+    file.write(reinterpret_cast<const char*>(payload), payload_size);
+
+    if (!file) {
+        throw std::runtime_error("Could not write model file.");
+    }
+}
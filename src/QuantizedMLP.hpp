@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "Layer.hpp"
+#include "ModelFormat.hpp"
+
+class MLP;
+class MappedFile;
+
+// Non-owning view of one reduced-precision layer: row-major weights whose rows
+// start on a cache line, fp32 biases and, for int8, one fp32 scale per row
+struct QuantizedLayer {
+  int inputs = 0;
+  int outputs = 0;
+  std::size_t stride = 0; // Weight elements between the starts of two rows
+  const void *weights = nullptr;
+  const float *biases = nullptr;
+  const float *scales = nullptr; // weight = scale * int8 value; null for 16-bit types
+};
+
+// Inference-only copy of an MLP with int8, bf16 or f16 weights, stored in the
+// same model container with the weight dtype in the header.
+// int8 layers round their inputs to 7-bit fixed point over [0, 1] (the range
+// of pixels and sigmoid outputs) and accumulate in int32, with VNNI where
+// available. 16-bit layers widen the weights and accumulate in fp32. Either
+// way the bandwidth-bound first layer reads 2-4x fewer weight bytes.
+class QuantizedMLP {
+public:
+  // dtype must be I8, BF16 or F16
+  QuantizedMLP(const MLP &model, DType dtype);
+  static QuantizedMLP open_mapped(const std::string &filename, bool verify_checksum = false);
+  QuantizedMLP(const QuantizedMLP &) = delete;
+  QuantizedMLP &operator=(const QuantizedMLP &) = delete;
+  QuantizedMLP(QuantizedMLP &&);
+  QuantizedMLP &operator=(QuantizedMLP &&);
+  ~QuantizedMLP();
+
+  void predict(std::span<const float> input, std::span<float> output);
+  // Batched form with the MLP::predict_batch layout; sizes are not checked here
+  void predict_batch(const float *inputs, std::size_t input_stride, float *outputs,
+                     std::size_t output_stride, int count);
+  void save_model(const std::string &filename) const;
+
+  DType dtype() const { return weight_type; }
+  const std::vector<int> &topology() const { return layer_sizes; }
+  const std::vector<QuantizedLayer> &layers() const { return layer_views; }
+  // Bytes of weights, scales and biases, padding included
+  std::size_t payload_bytes() const { return payload_size; }
+
+private:
+  QuantizedMLP() = default;
+  ModelDescription describe() const;
+  void bind_layers(const unsigned char *base, const ModelDescription &description);
+  // out rows = f(layer(in rows)) for count samples
+  void run_layer(const QuantizedLayer &layer, const float *in, std::size_t in_stride,
+                 float *out, std::size_t out_stride, int count);
+
+  DType weight_type = DType::I8;
+  std::vector<int> layer_sizes;
+  std::vector<QuantizedLayer> layer_views;
+  AlignedVector<unsigned char> storage; // Holds the payload of converted models
+  std::unique_ptr<MappedFile> mapping;  // Holds it instead after open_mapped
+  const unsigned char *payload = nullptr;
+  std::size_t payload_size = 0;
+  AlignedVector<float> scratch[2];       // Ping-pong activation rows
+  AlignedVector<std::uint8_t> quantized; // 7-bit input rows of the current int8 layer
+};
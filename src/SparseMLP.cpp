@@ -0,0 +1,439 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+// SparseMLP.cpp
+#include "SparseMLP.hpp"
+#include "Gemm.hpp"
+#include "MLP.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp" // For the MLP built by unpack
+
+namespace {
+
+// Entries per layer in the layer format table: format, block rows, block columns, blocks
+constexpr int kTableColumns = 4;
+// Multiply-adds per timed run when picking the fastest format, and runs kept at best
+constexpr std::size_t kTimingWork = std::size_t{1} << 22;
+constexpr int kTimingRuns = 5;
+
+bool valid_sparse_block(int block_rows, int block_cols) {
+    if (block_rows == 1 && block_cols == 1) {
+        return true;
+    }
+    return (block_rows == 1 || block_rows == 2 || block_rows == 4 || block_rows == 8) &&
+           (block_cols == 8 || block_cols == 16);
+}
+
+int row_blocks(int rows, int block_rows) {
+    return (rows + block_rows - 1) / block_rows;
+}
+
+// Tiles of one dense layer holding a nonzero weight, in block CSR order
+struct PackedLayer {
+    std::vector<float> values;
+    std::vector<std::int32_t> columns;
+    std::vector<std::int32_t> row_offsets;
+};
+
+PackedLayer pack_layer(const LayerView& layer, int block_rows, int block_cols) {
+    PackedLayer packed;
+    packed.row_offsets.push_back(0);
+    for (int i = 0; i < row_blocks(layer.outputs, block_rows); ++i) {
+        const int first_row = i * block_rows;
+        const int rows = std::min(block_rows, layer.outputs - first_row);
+        for (int c = 0; c < layer.inputs; c += block_cols) {
+            // Row padding is zero, so a tile may run past the last input
+            bool nonzero = false;
+            for (int r = 0; r < rows && !nonzero; ++r) {
+                const float* row = layer.row(first_row + r) + c;
+                nonzero = std::any_of(row, row + block_cols, [](float w) { return w != 0.0f; });
+            }
+            if (!nonzero) {
+                continue;
+            }
+            packed.columns.push_back(c);
+            for (int r = 0; r < block_rows; ++r) {
+                for (int k = 0; k < block_cols; ++k) {
+                    packed.values.push_back(r < rows ? layer.row(first_row + r)[c + k] : 0.0f);
+                }
+            }
+        }
+        packed.row_offsets.push_back(static_cast<std::int32_t>(packed.columns.size()));
+    }
+    return packed;
+}
+
+std::size_t dense_bytes(const LayerView& layer) {
+    return align_offset(layer.outputs * layer.stride * sizeof(float));
+}
+
+std::size_t sparse_bytes(const PackedLayer& packed) {
+    return align_offset(packed.values.size() * sizeof(float)) + align_offset(packed.columns.size() * sizeof(std::int32_t)) +
+           align_offset(packed.row_offsets.size() * sizeof(std::int32_t));
+}
+
+// Best time of repeated calls, in seconds per call
+template <typename Work>
+double time_call(std::size_t repeats, Work work) {
+    double best = 1e30;
+    for (int run = 0; run < kTimingRuns; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < repeats; ++i) {
+            work();
+        }
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best / repeats;
+}
+
+// Times one sample through both forms of the layer
+bool sparse_is_faster(const LayerView& layer, const kernels::BlockSparseMatrix& matrix) {
+    AlignedVector<float> x(layer.stride, 0.0f);
+    for (int k = 0; k < layer.inputs; ++k) {
+        x[k] = static_cast<float>(k % 97) / 96.0f; // Any activations in [0, 1]
+    }
+    std::vector<float> y(layer.outputs);
+    const std::size_t repeats = std::max<std::size_t>(1, kTimingWork / (static_cast<std::size_t>(layer.outputs) * layer.inputs));
+    const double dense = time_call(repeats, [&] {
+        gemm(Transpose::No, Transpose::Yes, 1, layer.outputs, layer.inputs, 1.0f, x.data(), layer.stride, layer.weights,
+             layer.stride, 0.0f, y.data(), y.size());
+    });
+    const double sparse = time_call(repeats, [&] { kernels::block_sparse_multiply(matrix, x.data(), x.size(), y.data(), y.size(), 1); });
+    return sparse < dense;
+}
+
+} // namespace
+
+void check_sparse_block(int block_rows, int block_cols) {
+    if (!valid_sparse_block(block_rows, block_cols)) {
+        throw std::invalid_argument("Sparse blocks must be 1x1, or 1, 2, 4 or 8 rows by 8 or 16 columns.");
+    }
+}
+
+double SparseLayer::density() const {
+    if (format == LayerFormat::Dense) {
+        return 1.0;
+    }
+    const int blocks = matrix.row_offsets[row_blocks(outputs, matrix.block_rows)];
+    return static_cast<double>(blocks) * matrix.block_rows * matrix.block_cols / (static_cast<double>(outputs) * inputs);
+}
+
+SparseMLP::SparseMLP(const MLP& model, FormatPolicy policy, int block_rows, int block_cols)
+    : layer_sizes(model.topology()), learning_rate(model.learning_rate) {
+    check_sparse_block(block_rows, block_cols);
+
+    // Pack every layer, then keep the sparse form where the policy prefers it
+    const std::vector<LayerView>& source = model.layers();
+    std::vector<PackedLayer> packed;
+    for (size_t i = 0; i < source.size(); ++i) {
+        packed.push_back(pack_layer(source[i], block_rows, block_cols));
+        const PackedLayer& layer = packed.back();
+
+        bool sparse = policy == FormatPolicy::Sparse;
+        if (policy == FormatPolicy::Smallest || policy == FormatPolicy::Fastest) {
+            sparse = sparse_bytes(layer) < dense_bytes(source[i]); // Otherwise it reads more bytes than dense
+        }
+        if (sparse && policy == FormatPolicy::Fastest) {
+            kernels::BlockSparseMatrix matrix;
+            matrix.rows = source[i].outputs;
+            matrix.cols = source[i].inputs;
+            matrix.block_rows = block_rows;
+            matrix.block_cols = block_cols;
+            matrix.values = layer.values.data();
+            matrix.columns = layer.columns.data();
+            matrix.row_offsets = layer.row_offsets.data();
+            sparse = sparse_is_faster(source[i], matrix);
+        }
+        // Dense layers of an unpruned model record no tile shape, so they load without a mask
+        const bool shaped = sparse || model.pruned();
+        formats.insert(formats.end(), {static_cast<std::int32_t>(sparse ? LayerFormat::Sparse : LayerFormat::Dense),
+                                       shaped ? block_rows : 0, shaped ? block_cols : 0,
+                                       static_cast<std::int32_t>(layer.columns.size())});
+    }
+
+    const ModelDescription description = describe();
+    payload_size = description.header.payload_bytes;
+    storage.assign(payload_size, 0); // Zero padding, which the kernels read
+    bind_layers(storage.data(), description);
+
+    // The views are read-only, so write through the same offsets into storage
+    auto writable = [&](const void* tensor) { return storage.data() + (static_cast<const unsigned char*>(tensor) - payload); };
+    std::memcpy(writable(payload), formats.data(), formats.size() * sizeof(std::int32_t));
+    for (size_t i = 0; i < layer_views.size(); ++i) {
+        const LayerView& from = source[i];
+        const SparseLayer& to = layer_views[i];
+        if (to.format == LayerFormat::Dense) {
+            float* weights = reinterpret_cast<float*>(writable(to.weights));
+            for (int j = 0; j < from.outputs; ++j) {
+                std::copy_n(from.row(j), from.inputs, weights + j * to.stride);
+            }
+        } else {
+            std::copy(packed[i].values.begin(), packed[i].values.end(), reinterpret_cast<float*>(writable(to.matrix.values)));
+            std::copy(packed[i].columns.begin(), packed[i].columns.end(), reinterpret_cast<std::int32_t*>(writable(to.matrix.columns)));
+            std::copy(packed[i].row_offsets.begin(), packed[i].row_offsets.end(),
+                      reinterpret_cast<std::int32_t*>(writable(to.matrix.row_offsets)));
+        }
+        std::copy_n(from.biases, from.outputs, reinterpret_cast<float*>(writable(to.biases)));
+    }
+}
+
+SparseMLP SparseMLP::open_mapped(const std::string& filename, bool verify_checksum) {
+    auto mapping = std::make_unique<MappedFile>(filename);
+    ModelDescription description = parse_model_description(mapping->data(), mapping->size(), mapping->size());
+
+    SparseMLP model;
+    model.learning_rate = description.header.learning_rate;
+    model.layer_sizes = description.layer_sizes;
+    const size_t layers = model.layer_sizes.size() - 1;
+    if (description.header.version != kSparseModelVersion || description.header.dtype != static_cast<uint32_t>(DType::F32) ||
+        description.header.activation != static_cast<uint32_t>(Activation::Sigmoid)) {
+        throw std::runtime_error("Model file is not a sparse sigmoid network.");
+    }
+    const unsigned char* payload = mapping->data() + description.header.payload_offset;
+    if (verify_checksum && model_checksum(payload, description.header.payload_bytes) != description.header.checksum) {
+        throw std::runtime_error("Model file checksum mismatch.");
+    }
+
+    // The layer format table fixes the rest of the layout
+    if (description.tensors.empty() || description.tensors[0].dtype != static_cast<uint32_t>(DType::I32) ||
+        description.tensors[0].rows != layers || description.tensors[0].cols != kTableColumns) {
+        throw std::runtime_error("Model file has no layer format table.");
+    }
+    model.formats.resize(layers * kTableColumns);
+    std::memcpy(model.formats.data(), mapping->data() + description.tensors[0].offset, model.formats.size() * sizeof(std::int32_t));
+    for (size_t i = 0; i < layers; ++i) {
+        const std::int32_t* format = model.formats.data() + i * kTableColumns;
+        const bool sparse = format[0] == static_cast<std::int32_t>(LayerFormat::Sparse);
+        const bool unshaped = format[1] == 0 && format[2] == 0;
+        if ((!sparse && (format[0] != static_cast<std::int32_t>(LayerFormat::Dense) ||
+                         !(unshaped || valid_sparse_block(format[1], format[2])))) ||
+            (sparse && (!valid_sparse_block(format[1], format[2]) || format[3] < 0))) {
+            throw std::runtime_error("Corrupt layer format table in model file.");
+        }
+    }
+    const ModelDescription expected = model.describe();
+    if (description.header.payload_offset != expected.header.payload_offset ||
+        description.header.payload_bytes != expected.header.payload_bytes ||
+        description.tensors.size() != expected.tensors.size() ||
+        std::memcmp(description.tensors.data(), expected.tensors.data(), expected.tensors.size() * sizeof(TensorEntry)) != 0) {
+        throw std::runtime_error("Model file tensor layout does not match its topology.");
+    }
+    model.payload_size = description.header.payload_bytes;
+    model.bind_layers(payload, description);
+
+    // The kernels trust the indices, so check every block lies inside its padded rows
+    for (const SparseLayer& layer : model.layer_views) {
+        if (layer.format == LayerFormat::Dense) {
+            continue;
+        }
+        const kernels::BlockSparseMatrix& matrix = layer.matrix;
+        const int blocks = row_blocks(layer.outputs, matrix.block_rows);
+        bool valid = matrix.row_offsets[0] == 0;
+        for (int i = 0; i < blocks && valid; ++i) {
+            valid = matrix.row_offsets[i] <= matrix.row_offsets[i + 1];
+        }
+        const std::int32_t stored = matrix.row_offsets[blocks];
+        valid = valid && stored == model.formats[(&layer - model.layer_views.data()) * kTableColumns + 3];
+        const std::int64_t limit = static_cast<std::int64_t>(aligned_floats(layer.inputs)) - matrix.block_cols;
+        for (std::int32_t k = 0; k < stored && valid; ++k) {
+            valid = matrix.columns[k] >= 0 && matrix.columns[k] <= limit && matrix.columns[k] < layer.inputs;
+        }
+        if (!valid) {
+            throw std::runtime_error("Corrupt sparse layer in model file.");
+        }
+    }
+    model.mapping = std::move(mapping);
+    return model;
+}
+
+SparseMLP::SparseMLP(SparseMLP&&) = default;
+SparseMLP& SparseMLP::operator=(SparseMLP&&) = default;
+SparseMLP::~SparseMLP() = default;
+
+ModelDescription SparseMLP::describe() const {
+    ModelDescription description;
+    ModelHeader& header = description.header;
+    std::memcpy(header.magic, kModelMagic, sizeof(kModelMagic));
+    header.version = kSparseModelVersion;
+    header.dtype = static_cast<uint32_t>(DType::F32);
+    header.activation = static_cast<uint32_t>(Activation::Sigmoid);
+    header.layer_count = static_cast<uint32_t>(layer_sizes.size());
+    header.learning_rate = learning_rate;
+    header.tensor_count = 1;
+    for (size_t i = 1; i < layer_sizes.size(); ++i) {
+        header.tensor_count += formats[(i - 1) * kTableColumns] == static_cast<std::int32_t>(LayerFormat::Sparse) ? 4 : 2;
+    }
+    description.layer_sizes = layer_sizes;
+    description.tensors.resize(header.tensor_count);
+    header.payload_offset = align_offset(description.header_bytes());
+
+    // The format table, then per layer dense weights, or block values, block
+    // columns and block row offsets, then biases; each on a 64-byte boundary
+    uint64_t offset = header.payload_offset;
+    auto place = [&](TensorEntry& tensor, uint32_t rows, uint32_t cols, DType dtype) {
+        const size_t element_bytes = dtype_size(dtype);
+        tensor.offset = offset;
+        tensor.rows = rows;
+        tensor.cols = cols;
+        tensor.stride = static_cast<uint32_t>(align_offset(cols * element_bytes) / element_bytes);
+        tensor.bytes = static_cast<uint64_t>(rows) * tensor.stride * element_bytes;
+        tensor.dtype = static_cast<uint32_t>(dtype);
+        offset = align_offset(offset + tensor.bytes);
+    };
+    TensorEntry* tensor = description.tensors.data();
+    place(*tensor++, static_cast<uint32_t>(layer_sizes.size() - 1), kTableColumns, DType::I32);
+    for (size_t i = 1; i < layer_sizes.size(); ++i) {
+        const std::int32_t* format = formats.data() + (i - 1) * kTableColumns;
+        if (format[0] == static_cast<std::int32_t>(LayerFormat::Sparse)) {
+            const uint32_t blocks = static_cast<uint32_t>(format[3]);
+            place(*tensor++, 1, blocks * format[1] * format[2], DType::F32);
+            place(*tensor++, 1, blocks, DType::I32);
+            place(*tensor++, 1, row_blocks(layer_sizes[i], format[1]) + 1, DType::I32);
+        } else {
+            place(*tensor++, layer_sizes[i], layer_sizes[i - 1], DType::F32);
+        }
+        place(*tensor++, 1, layer_sizes[i], DType::F32);
+    }
+    header.payload_bytes = offset - header.payload_offset;
+    return description;
+}
+
+void SparseMLP::bind_layers(const unsigned char* base, const ModelDescription& description) {
+    payload = base;
+    const uint64_t origin = description.header.payload_offset;
+    auto at = [&](const TensorEntry& tensor) { return base + (tensor.offset - origin); };
+    const TensorEntry* tensor = description.tensors.data() + 1;
+    layer_views.clear();
+    for (size_t i = 1; i < layer_sizes.size(); ++i) {
+        const std::int32_t* format = formats.data() + (i - 1) * kTableColumns;
+        SparseLayer layer;
+        layer.inputs = layer_sizes[i - 1];
+        layer.outputs = layer_sizes[i];
+        layer.format = static_cast<LayerFormat>(format[0]);
+        if (layer.format == LayerFormat::Sparse) {
+            layer.matrix.rows = layer.outputs;
+            layer.matrix.cols = layer.inputs;
+            layer.matrix.block_rows = format[1];
+            layer.matrix.block_cols = format[2];
+            layer.matrix.values = reinterpret_cast<const float*>(at(tensor[0]));
+            layer.matrix.columns = reinterpret_cast<const std::int32_t*>(at(tensor[1]));
+            layer.matrix.row_offsets = reinterpret_cast<const std::int32_t*>(at(tensor[2]));
+            tensor += 3;
+        } else {
+            layer.stride = tensor->stride;
+            layer.weights = reinterpret_cast<const float*>(at(*tensor));
+            tensor += 1;
+        }
+        layer.biases = reinterpret_cast<const float*>(at(*tensor++));
+        layer_views.push_back(layer);
+    }
+}
+
+void SparseMLP::predict(std::span<const float> input, std::span<float> output) {
+    if (input.size() != static_cast<size_t>(layer_sizes.front())) {
+        throw std::invalid_argument("Input size does not match the input layer size.");
+    }
+    if (output.size() != static_cast<size_t>(layer_sizes.back())) {
+        throw std::invalid_argument("Output size does not match the output layer size.");
+    }
+    predict_batch(input.data(), input.size(), output.data(), output.size(), 1);
+}
+
+void SparseMLP::predict_batch(const float* inputs, size_t input_stride, float* outputs, size_t output_stride, int count) {
+    // Only grows; padding past the inputs is never written, so it stays zero
+    const size_t stride = aligned_floats(*std::max_element(layer_sizes.begin(), layer_sizes.end()));
+    for (AlignedVector<float>& buffer : scratch) {
+        if (buffer.size() < count * stride) {
+            buffer.resize(count * stride);
+        }
+    }
+    // Input rows are copied into padded rows, as column blocks may run past the last input
+    for (int b = 0; b < count; ++b) {
+        std::copy_n(inputs + b * input_stride, layer_sizes.front(), scratch[0].data() + b * stride);
+    }
+
+    // Hidden activations alternate between the other two scratch matrices.
+    // Their padding holds stale activations, which only meet zero weights.
+    const float* in = scratch[0].data();
+    for (size_t i = 0; i < layer_views.size(); ++i) {
+        const SparseLayer& layer = layer_views[i];
+        const bool last = i + 1 == layer_views.size();
+        float* out = last ? outputs : scratch[1 + i % 2].data();
+        const size_t out_stride = last ? output_stride : stride;
+        if (layer.format == LayerFormat::Sparse) {
+            kernels::block_sparse_multiply(layer.matrix, in, stride, out, out_stride, count);
+        } else {
+            gemm(Transpose::No, Transpose::Yes, count, layer.outputs, layer.inputs, 1.0f, in, stride, layer.weights,
+                 layer.stride, 0.0f, out, out_stride);
+        }
+        for (int b = 0; b < count; ++b) {
+            kernels::bias_sigmoid(out + b * out_stride, layer.biases, layer.outputs);
+        }
+        in = out;
+    }
+}
+
+void SparseMLP::save_model(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file to save model.");
+    }
+
+    ModelDescription description = describe();
+    description.header.checksum = model_checksum(payload, payload_size);
+    write_model_description(file, description);
+    file.write(reinterpret_cast<const char*>(payload), payload_size);
+
+    if (!file) {
+        throw std::runtime_error("Could not write model file.");
+    }
+}
+
+MLP SparseMLP::unpack() const {
+    MLP mlp;
+    mlp.learning_rate = learning_rate;
+    mlp.allocate(layer_sizes);
+    const float* base = mlp.layer_views.front().weights;
+    for (size_t i = 0; i < layer_views.size(); ++i) {
+        const SparseLayer& from = layer_views[i];
+        const LayerView& to = mlp.layer_views[i];
+        std::copy_n(from.biases, from.outputs, to.biases);
+        if (from.format == LayerFormat::Dense) {
+            for (int j = 0; j < from.outputs; ++j) {
+                std::copy_n(from.weights + j * from.stride, from.inputs, to.row(j));
+            }
+            // A dense layer of a pruned model keeps its zeroed tiles pruned
+            const std::int32_t* format = formats.data() + i * kTableColumns;
+            if (format[1] > 0) {
+                mlp.mask_zero_tiles(i, format[1], format[2]);
+            }
+            continue;
+        }
+
+        // Scatter the stored tiles; everything else in the layer is pruned
+        const kernels::BlockSparseMatrix& matrix = from.matrix;
+        if (mlp.prune_mask.empty()) {
+            mlp.prune_mask.assign(mlp.parameter_count, 1);
+        }
+        unsigned char* mask = mlp.prune_mask.data() + (to.weights - base);
+        std::fill(mask, mask + to.outputs * to.stride, 0);
+        const size_t block_size = static_cast<size_t>(matrix.block_rows) * matrix.block_cols;
+        for (int r0 = 0, i0 = 0; r0 < from.outputs; r0 += matrix.block_rows, ++i0) {
+            const int rows = std::min(matrix.block_rows, from.outputs - r0);
+            for (std::int32_t k = matrix.row_offsets[i0]; k < matrix.row_offsets[i0 + 1]; ++k) {
+                const int columns = std::min(matrix.block_cols, from.inputs - matrix.columns[k]);
+                for (int r = 0; r < rows; ++r) {
+                    const size_t position = (r0 + r) * to.stride + matrix.columns[k];
+                    std::copy_n(matrix.values + k * block_size + r * matrix.block_cols, columns, to.weights + position);
+                    std::fill_n(mask + position, columns, 1);
+                }
+            }
+        }
+        mlp.prune_block_rows = matrix.block_rows;
+        mlp.prune_block_cols = matrix.block_cols;
+    }
+    return mlp;
+}
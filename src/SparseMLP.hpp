@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "Kernels.hpp"
+#include "Layer.hpp"
+#include "ModelFormat.hpp"
+
+class MLP;
+class MappedFile;
+
+// Storage of one layer, recorded per layer in sparse model files
+enum class LayerFormat : std::uint32_t { Dense = 0, Sparse = 1 };
+
+// How SparseMLP picks each layer's format
+enum class FormatPolicy {
+  Fastest,  // Times both forms on one sample and keeps the quicker one; used by MLP::save_model
+  Smallest, // Keeps whichever takes fewer bytes; deterministic, unlike Fastest
+  Dense,
+  Sparse
+};
+
+// Throws std::invalid_argument unless the block shape is 1x1, or 1, 2, 4 or
+// 8 rows by 8 or 16 columns: the shapes with vector kernels
+void check_sparse_block(int block_rows, int block_cols);
+
+// Non-owning view of one layer in either format; biases are always dense
+struct SparseLayer {
+  int inputs = 0;
+  int outputs = 0;
+  LayerFormat format = LayerFormat::Dense;
+  std::size_t stride = 0;          // Dense: floats between the starts of two weight rows
+  const float *weights = nullptr;  // Dense only
+  kernels::BlockSparseMatrix matrix; // Sparse only
+  const float *biases = nullptr;
+
+  // Stored weights over all weights: 1 for dense layers
+  double density() const;
+};
+
+// Inference copy of a pruned MLP. Layers whose weights are mostly zero keep
+// only their nonzero block_rows x block_cols tiles, multiplied with the
+// block-sparse kernels; the rest stay dense and run through the GEMM. Saved
+// in the model container as version 2, so the stored tiles map in place.
+// The layer format table records the prune tile shape for dense layers too
+// (0x0 when the model was never pruned), so unpack can rebuild their mask.
+class SparseMLP {
+public:
+  // A tile is stored when any of its weights is nonzero; MLP::prune zeroes whole tiles
+  SparseMLP(const MLP &model, FormatPolicy policy = FormatPolicy::Fastest, int block_rows = 1,
+            int block_cols = 1);
+  static SparseMLP open_mapped(const std::string &filename, bool verify_checksum = false);
+  SparseMLP(const SparseMLP &) = delete;
+  SparseMLP &operator=(const SparseMLP &) = delete;
+  SparseMLP(SparseMLP &&);
+  SparseMLP &operator=(SparseMLP &&);
+  ~SparseMLP();
+
+  void predict(std::span<const float> input, std::span<float> output);
+  // Batched form with the MLP::predict_batch layout; sizes are not checked here
+  void predict_batch(const float *inputs, std::size_t input_stride, float *outputs,
+                     std::size_t output_stride, int count);
+  void save_model(const std::string &filename) const;
+  // Dense copy of the weights. Tiles missing from sparse layers, and all-zero
+  // tiles of dense layers from a pruned model, stay pruned, so training it
+  // fine-tunes without bringing them back.
+  MLP unpack() const;
+
+  const std::vector<int> &topology() const { return layer_sizes; }
+  const std::vector<SparseLayer> &layers() const { return layer_views; }
+  // Bytes of weights, indices and biases, padding included
+  std::size_t payload_bytes() const { return payload_size; }
+
+private:
+  SparseMLP() = default;
+  ModelDescription describe() const;
+  void bind_layers(const unsigned char *base, const ModelDescription &description);
+
+  std::vector<int> layer_sizes;
+  float learning_rate = 0.0f;
+  // Per layer: format, block rows, block columns and stored blocks, as in the
+  // file's layer format table
+  std::vector<std::int32_t> formats;
+  std::vector<SparseLayer> layer_views;
+  AlignedVector<unsigned char> storage; // Holds the payload of converted models
+  std::unique_ptr<MappedFile> mapping;  // Holds it instead after open_mapped
+  const unsigned char *payload = nullptr;
+  std::size_t payload_size = 0;
+  AlignedVector<float> scratch[3]; // Padded input rows, then ping-pong activation rows
+};
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Kernels.hpp"
+#include "Layer.hpp"
+#include "MLP.hpp"
+#include "ModelFormat.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define STATIC_MLP_X86 1
+#endif
+// Everything a forward pass calls is inlined into the per-ISA entry points, so
+// it is compiled for that ISA
+#define STATIC_MLP_INLINE inline __attribute__((always_inline))
+
+// Activation policies for BasicStaticMLP: the model file activation they
+// match and the function applied to every pre-activation
+struct SigmoidActivation {
+  static constexpr Activation kind = Activation::Sigmoid;
+  static STATIC_MLP_INLINE float apply(float x) {
+    return 1.0f / (1.0f + kernels::exp_approx(-x));
+  }
+};
+
+// Inference-only network whose layer sizes are template arguments, for
+// deployed models whose topology never changes. It loads the same model files
+// as MLP, keeps every weight in one fixed-size aligned array and runs each
+// layer as a fully sized matrix-vector loop with the bias folded into the
+// accumulators and the activation applied before they are stored. Nothing is
+// checked or allocated per call.
+// Weights are kept transposed ([inputs x outputs], outputs padded to a cache
+// line) so the loops vectorize across neurons rather than along a dot product.
+// Unlike MLP::predict, outputs are never blended with the input; the two agree
+// for any model loaded from a file. Large networks belong on the heap.
+template <typename ActivationPolicy, int... Sizes> class BasicStaticMLP {
+  static_assert(sizeof...(Sizes) >= 2, "There must be at least two layers (input and output).");
+  static_assert(((Sizes > 0) && ...), "Layer sizes must be greater than zero.");
+
+  static constexpr std::array<int, sizeof...(Sizes)> kSizes = {Sizes...};
+
+public:
+  static constexpr std::size_t kLayers = sizeof...(Sizes) - 1; // Weight layers
+  static constexpr int kInputs = kSizes.front();
+  static constexpr int kOutputs = kSizes.back();
+
+  // All weights and biases start at zero
+  BasicStaticMLP() : isa(kernels::active_isa()) {}
+  explicit BasicStaticMLP(const MLP &model) : BasicStaticMLP() { load(model); }
+
+  // Copies the weights of a network with the same topology; throws
+  // std::invalid_argument otherwise
+  void load(const MLP &model) {
+    if (model.topology() != std::vector<int>{Sizes...}) {
+      throw std::invalid_argument("Model topology does not match this network.");
+    }
+    for (std::size_t i = 0; i < kLayers; ++i) {
+      const LayerView &layer = model.layers()[i];
+      const std::size_t cols = columns(i);
+      float *weights = parameters.data() + offset(i);
+      for (int j = 0; j < layer.outputs; ++j) {
+        const float *row = layer.row(j);
+        for (int k = 0; k < layer.inputs; ++k) {
+          weights[k * cols + j] = row[k];
+        }
+      }
+      std::copy_n(layer.biases, layer.outputs, weights + layer.inputs * cols);
+    }
+  }
+  // Reads a model file saved by MLP, checksum included
+  void load_model(const std::string &filename) {
+    if (read_model_header(filename).activation != static_cast<std::uint32_t>(ActivationPolicy::kind)) {
+      throw std::runtime_error("Model file activation does not match this network.");
+    }
+    load(MLP::open_mapped(filename, true));
+  }
+
+  // Thread-safe: the layer buffers live on the caller's stack
+  void predict(std::span<const float, kInputs> input, std::span<float, kOutputs> output) const {
+    predict(input.data(), output.data());
+  }
+  void predict(const float *input, float *output) const {
+    switch (isa) {
+#ifdef STATIC_MLP_X86
+    case kernels::Isa::AVX512:
+    case kernels::Isa::AVX512VNNI:
+      forward_avx512(input, output);
+      break;
+    case kernels::Isa::AVX2:
+      forward_avx2(input, output);
+      break;
+#endif
+    default:
+      forward<false>(input, output, std::make_index_sequence<kLayers>{});
+      break;
+    }
+  }
+
+private:
+  // Floats in one transposed weight row and in the bias vector of a layer
+  static constexpr std::size_t columns(std::size_t layer) { return aligned_floats(kSizes[layer + 1]); }
+  // Start of a layer's weights; its biases follow the weights
+  static constexpr std::size_t offset(std::size_t layer) {
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < layer; ++i) {
+      total += (kSizes[i] + 1) * columns(i);
+    }
+    return total;
+  }
+  static constexpr std::size_t widest() {
+    std::size_t result = 0;
+    for (std::size_t i = 0; i < kLayers; ++i) {
+      result = std::max(result, columns(i));
+    }
+    return result;
+  }
+
+  template <bool Fma> static STATIC_MLP_INLINE float multiply_add(float a, float b, float c) {
+    if constexpr (Fma) {
+      return std::fma(a, b, c);
+    } else {
+      return c + a * b;
+    }
+  }
+
+  // out[0, columns) = f(in * W + b) for a block of up to 64 neurons at a time,
+  // held in registers. Narrow blocks split the inputs over several independent
+  // sums so the multiply-adds are not serialized on one register.
+  template <std::size_t Layer, bool Fma> STATIC_MLP_INLINE void run_layer(const float *in, float *out) const {
+    constexpr int inputs = kSizes[Layer];
+    constexpr int cols = static_cast<int>(columns(Layer));
+    constexpr int block = cols % 64 == 0 ? 64 : (cols % 32 == 0 ? 32 : 16);
+    constexpr int chains = 64 / block;
+    const float *weights = parameters.data() + offset(Layer);
+    const float *biases = weights + inputs * cols;
+    for (int j0 = 0; j0 < cols; j0 += block) {
+      float acc[chains][block] = {};
+      int k = 0;
+      for (; k + chains <= inputs; k += chains) {
+#pragma GCC unroll 8
+        for (int c = 0; c < chains; ++c) {
+          const float x = in[k + c];
+          const float *w = weights + (k + c) * cols + j0;
+          for (int j = 0; j < block; ++j) {
+            acc[c][j] = multiply_add<Fma>(x, w[j], acc[c][j]);
+          }
+        }
+      }
+      for (; k < inputs; ++k) {
+        const float x = in[k];
+        const float *w = weights + k * cols + j0;
+        for (int j = 0; j < block; ++j) {
+          acc[0][j] = multiply_add<Fma>(x, w[j], acc[0][j]);
+        }
+      }
+      for (int j = 0; j < block; ++j) {
+        float sum = biases[j0 + j];
+        for (int c = 0; c < chains; ++c) {
+          sum += acc[c][j];
+        }
+        out[j0 + j] = ActivationPolicy::apply(sum);
+      }
+    }
+  }
+
+  template <bool Fma, std::size_t... Layer>
+  STATIC_MLP_INLINE void forward(const float *input, float *output, std::index_sequence<Layer...>) const {
+    alignas(kLayerAlignment) float buffers[2][widest()]; // Ping-pong activation rows
+    (run_layer<Layer, Fma>(Layer == 0 ? input : buffers[(Layer + 1) % 2], buffers[Layer % 2]), ...);
+    std::copy_n(buffers[(kLayers - 1) % 2], kOutputs, output);
+  }
+
+#ifdef STATIC_MLP_X86
+  __attribute__((target("avx2,fma"))) void forward_avx2(const float *input, float *output) const {
+    forward<true>(input, output, std::make_index_sequence<kLayers>{});
+  }
+  __attribute__((target("avx512f,fma"))) void forward_avx512(const float *input, float *output) const {
+    forward<true>(input, output, std::make_index_sequence<kLayers>{});
+  }
+#endif
+
+  alignas(kLayerAlignment) std::array<float, offset(kLayers)> parameters{};
+  kernels::Isa isa;
+};
+
+template <int... Sizes> using StaticMLP = BasicStaticMLP<SigmoidActivation, Sizes...>;
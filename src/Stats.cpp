@@ -0,0 +1,34 @@
+// Stats.cpp
+#include "Stats.hpp"
+
+namespace stats {
+namespace {
+
+std::atomic<std::uint64_t> allocations{0};
+std::atomic<std::uint64_t> bytes_allocated{0};
+
+} // namespace
+
+void count_allocation(std::size_t bytes) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    bytes_allocated.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void ModelCounters::reset() {
+    for (std::size_t i = 0; i < count; ++i) {
+        layers[i].forward.store(0, std::memory_order_relaxed);
+        layers[i].backward.store(0, std::memory_order_relaxed);
+        layers[i].update.store(0, std::memory_order_relaxed);
+    }
+    all_reduce.store(0, std::memory_order_relaxed);
+}
+
+std::uint64_t allocation_count() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+std::uint64_t allocated_bytes() {
+    return bytes_allocated.load(std::memory_order_relaxed);
+}
+
+} // namespace stats
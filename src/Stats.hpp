@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Seconds spent in one weight layer, summed over worker threads
+struct LayerTimes {
+  double forward = 0.0;  // GEMM plus bias and activation
+  double backward = 0.0; // Delta of this layer
+  double update = 0.0;   // Weight and bias gradient, applied in place on one thread
+};
+
+// Reported after every epoch. The per-layer times and allocation counts are
+// only filled in when the library is built with MLP_STATS.
+struct EpochStats {
+  int epoch = 0; // 1-based
+  int epochs = 0;
+  std::size_t samples = 0;
+  float loss = 0.0f;             // Mean squared error per output over the epoch
+  float validation_loss = -1.0f; // The same on the validation set; negative without one
+  float learning_rate = 0.0f;    // Scheduled rate of the epoch
+  double seconds = 0.0; // Wall time of the epoch
+  std::vector<LayerTimes> layers;
+  double all_reduce_seconds = 0.0;   // Gradient reduction and update with several threads
+  std::uint64_t allocations = 0;     // Aligned buffer allocations during the epoch
+  std::uint64_t allocated_bytes = 0;
+};
+
+using StatsCallback = std::function<void(const EpochStats &)>;
+
+namespace stats {
+
+#ifdef MLP_STATS
+constexpr bool kEnabled = true;
+#else
+constexpr bool kEnabled = false;
+#endif
+
+using Counter = std::atomic<std::uint64_t>; // Nanoseconds, relaxed adds only
+
+struct LayerCounters {
+  Counter forward{0};
+  Counter backward{0};
+  Counter update{0};
+};
+
+// Per-layer counters of one network plus the multi-threaded reduction
+struct ModelCounters {
+  explicit ModelCounters(std::size_t layer_count) : layers(new LayerCounters[layer_count]), count(layer_count) {}
+  void reset();
+
+  std::unique_ptr<LayerCounters[]> layers;
+  std::size_t count;
+  Counter all_reduce{0};
+};
+
+// Adds the time until the end of the scope to a counter
+class ScopedTimer {
+public:
+  explicit ScopedTimer(Counter &target) : target(target), start(std::chrono::steady_clock::now()) {}
+  ~ScopedTimer() {
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    target.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), std::memory_order_relaxed);
+  }
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+  Counter &target;
+  std::chrono::steady_clock::time_point start;
+};
+
+inline double seconds(const Counter &counter) {
+  return counter.load(std::memory_order_relaxed) * 1e-9;
+}
+
+// Process-wide, bumped by AlignedAllocator in MLP_STATS builds
+void count_allocation(std::size_t bytes);
+std::uint64_t allocation_count();
+std::uint64_t allocated_bytes();
+
+} // namespace stats
+
+// Times the rest of the enclosing scope into a stats::Counter; compiles to
+// nothing without MLP_STATS
+#ifdef MLP_STATS
+#define MLP_STATS_TIMER(name, counter) stats::ScopedTimer name(counter)
+#else
+#define MLP_STATS_TIMER(name, counter) ((void)0)
+#endif
@@ -0,0 +1,13 @@
+// StbImage.cpp
+// The single translation unit holding the stb_image implementations, shared
+// by the dataset loader and the executables
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+// GCC spelling, which clang accepts too
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+#pragma GCC diagnostic pop
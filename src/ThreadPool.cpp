@@ -0,0 +1,96 @@
+#include <algorithm>
+
+// ThreadPool.cpp
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(int threads) {
+    if (threads < 1) {
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    for (int i = 1; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    start.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::dispatch(void (*function)(void*, int), void* task) {
+    if (workers.empty()) {
+        function(task, 0);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job_function = function;
+        job_task = task;
+        pending = static_cast<int>(workers.size());
+        failure = nullptr;
+        ++generation;
+    }
+    start.notify_all();
+
+    execute(0);
+
+    // The task lives on the caller's stack, so even a failed job waits for every worker
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return pending == 0; });
+    if (failure) {
+        std::exception_ptr thrown = std::move(failure);
+        failure = nullptr;
+        lock.unlock();
+        std::rethrow_exception(thrown);
+    }
+}
+
+void ThreadPool::execute(int index) {
+    try {
+        job_function(job_task, index);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!failure) {
+            failure = std::current_exception();
+        }
+    }
+}
+
+void ThreadPool::worker_loop(int index) {
+    unsigned long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            start.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+
+        execute(index); // The job fields stay put until every worker is done
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0) {
+            finished.notify_one();
+        }
+    }
+}
+
+void SpinBarrier::wait() {
+    const unsigned current = phase.load(std::memory_order_acquire);
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        remaining.store(count, std::memory_order_relaxed);
+        phase.fetch_add(1, std::memory_order_release);
+        return;
+    }
+    while (phase.load(std::memory_order_acquire) == current) {
+        std::this_thread::yield();
+    }
+}
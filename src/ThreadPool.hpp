@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Persistent workers that all run the same task. The calling thread takes
+// part as worker 0, so a pool of size 1 runs tasks inline with no threads.
+class ThreadPool {
+public:
+  explicit ThreadPool(int threads);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  int size() const { return static_cast<int>(workers.size()) + 1; }
+
+  // Calls task(worker_index) once on every worker and returns when all are
+  // done. The task is passed by reference, so dispatch never allocates. If
+  // any worker throws, run still waits for every worker and then rethrows
+  // the first exception on the calling thread.
+  template <typename Task> void run(Task &&task) {
+    dispatch(&invoke<std::remove_reference_t<Task>>, &task);
+  }
+
+private:
+  template <typename Task> static void invoke(void *task, int worker) {
+    (*static_cast<Task *>(task))(worker);
+  }
+  void dispatch(void (*function)(void *, int), void *task);
+  void worker_loop(int index);
+  void execute(int index);
+
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable start;
+  std::condition_variable finished;
+  void (*job_function)(void *, int) = nullptr;
+  void *job_task = nullptr;
+  unsigned long generation = 0; // Bumped for every dispatched job
+  int pending = 0;              // Workers still running the current job
+  std::exception_ptr failure;   // First exception thrown by the current job
+  bool stopping = false;
+};
+
+// Reusable barrier for phases inside one ThreadPool task; waiting spins on an
+// atomic instead of taking a lock
+class SpinBarrier {
+public:
+  explicit SpinBarrier(int count) : count(count), remaining(count) {}
+  void wait();
+
+private:
+  const int count;
+  std::atomic<int> remaining;
+  std::atomic<unsigned> phase{0};
+};
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+// Tiling.cpp
+#include "Tiling.hpp"
+#include "MLP.hpp"
+#include "ThreadPool.hpp"
+
+std::vector<int> tile_positions(int length, int patch, int overlap) {
+    const int step = patch - overlap;
+    std::vector<int> positions;
+    for (int position = 0;; position += step) {
+        if (position + patch >= length) {
+            positions.push_back(std::max(0, length - patch));
+            return positions;
+        }
+        positions.push_back(position);
+    }
+}
+
+void extract_patch(const float* image, int width, int height, int x, int y, int patch, float* out) {
+    for (int v = 0; v < patch; ++v) {
+        const float* row = image + std::min(y + v, height - 1) * width;
+        if (x + patch <= width) {
+            std::copy_n(row + x, patch, out + v * patch);
+            continue;
+        }
+        for (int u = 0; u < patch; ++u) {
+            out[v * patch + u] = row[std::min(x + u, width - 1)];
+        }
+    }
+}
+
+TiledReconstructor::TiledReconstructor(const MLP& model, TileOptions options) : model(model), options(options) {
+    const int inputs = model.topology().front();
+    patch = static_cast<int>(std::lround(std::sqrt(static_cast<double>(inputs))));
+    if (patch * patch != inputs || model.topology().back() != inputs) {
+        throw std::invalid_argument("Tiled reconstruction needs a model mapping square patches to patches of the same size.");
+    }
+    if (options.overlap < 0 || options.overlap >= patch || options.batch_size < 1) {
+        throw std::invalid_argument("Overlap must be smaller than the patch and batches must hold at least one patch.");
+    }
+
+    pool = std::make_unique<ThreadPool>(options.threads);
+    workspaces.resize(pool->size());
+    batch_inputs.resize(pool->size());
+    for (int worker = 0; worker < pool->size(); ++worker) {
+        workspaces[worker].reserve(model.topology(), options.batch_size);
+        batch_inputs[worker].resize(static_cast<size_t>(options.batch_size) * inputs);
+    }
+
+    // Weights ramp up across the overlap at both edges so seams cross-fade
+    for (int u = 0; u < patch; ++u) {
+        const float ramp_length = static_cast<float>(options.overlap + 1);
+        ramp.push_back(std::min({1.0f, (u + 1) / ramp_length, (patch - u) / ramp_length}));
+    }
+}
+
+TiledReconstructor::~TiledReconstructor() = default;
+
+TileStats TiledReconstructor::reconstruct(std::span<const float> image, int width, int height, std::span<float> output) {
+    if (width <= 0 || height <= 0 || image.size() != static_cast<size_t>(width) * height || output.size() != image.size()) {
+        throw std::invalid_argument("Image and output must both hold width * height pixels.");
+    }
+    const auto start = std::chrono::steady_clock::now();
+
+    const std::vector<int> xs = tile_positions(width, patch, options.overlap);
+    const std::vector<int> ys = tile_positions(height, patch, options.overlap);
+    const int columns = static_cast<int>(xs.size());
+    const int tiles = columns * static_cast<int>(ys.size());
+    const size_t area = static_cast<size_t>(patch) * patch;
+    tile_outputs.resize(tiles * area);
+
+    // Workers pull batches of tiles from a shared counter
+    const int batches = (tiles + options.batch_size - 1) / options.batch_size;
+    std::atomic<int> next_batch{0};
+    pool->run([&](int worker) {
+        float* inputs = batch_inputs[worker].data();
+        for (int batch = next_batch++; batch < batches; batch = next_batch++) {
+            const int first = batch * options.batch_size;
+            const int count = std::min(options.batch_size, tiles - first);
+            for (int t = 0; t < count; ++t) {
+                const int tile = first + t;
+                extract_patch(image.data(), width, height, xs[tile % columns], ys[tile / columns], patch, inputs + t * area);
+            }
+            model.predict_batch(inputs, area, tile_outputs.data() + first * area, area, count, workspaces[worker]);
+        }
+    });
+
+    // Positions are increasing, so the tiles covering x are first_tile_x[x] onwards
+    first_tile_x.resize(width);
+    for (int x = 0, tile = 0; x < width; ++x) {
+        while (xs[tile] + patch <= x) {
+            ++tile;
+        }
+        first_tile_x[x] = tile;
+    }
+
+    // Each worker blends a band of output rows, gathering from the tiles that
+    // cover every pixel, so no two workers write the same pixel
+    const int threads = pool->size();
+    pool->run([&](int worker) {
+        int first_tile_y = 0;
+        for (int y = height * worker / threads; y < height * (worker + 1) / threads; ++y) {
+            while (ys[first_tile_y] + patch <= y) {
+                ++first_tile_y;
+            }
+            for (int x = 0; x < width; ++x) {
+                float sum = 0.0f;
+                float weight_sum = 0.0f;
+                for (int ty = first_tile_y; ty < static_cast<int>(ys.size()) && ys[ty] <= y; ++ty) {
+                    const int v = y - ys[ty];
+                    for (int tx = first_tile_x[x]; tx < columns && xs[tx] <= x; ++tx) {
+                        const int u = x - xs[tx];
+                        const float weight = ramp[u] * ramp[v];
+                        sum += weight * tile_outputs[(ty * columns + tx) * area + v * patch + u];
+                        weight_sum += weight;
+                    }
+                }
+                output[static_cast<size_t>(y) * width + x] = sum / weight_sum;
+            }
+        }
+    });
+
+    TileStats stats;
+    stats.patches = tiles;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.megapixels_per_second = static_cast<double>(width) * height / 1e6 / stats.seconds;
+    return stats;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "Layer.hpp"
+#include "Workspace.hpp"
+
+class MLP;
+class ThreadPool;
+
+// Top-left coordinates of patches covering [0, length) with the given overlap;
+// the last patch is pulled back so it ends on the border
+std::vector<int> tile_positions(int length, int patch, int overlap);
+
+// Copies the patch x patch window at (x, y) into out, replicating edge pixels
+// where the window runs past the image
+void extract_patch(const float *image, int width, int height, int x, int y, int patch, float *out);
+
+struct TileOptions {
+  int overlap = 0;     // Pixels shared by neighbouring patches, cross-faded with a linear ramp
+  int batch_size = 64; // Patches per forward pass
+  int threads = 0;     // 0 uses every hardware thread
+};
+
+struct TileStats {
+  int patches = 0;
+  double seconds = 0.0;
+  double megapixels_per_second = 0.0;
+};
+
+// Reconstructs images of any size with a model trained on square patches.
+// The image is cut into patch-sized tiles, tiles are pushed through the network
+// in batches spread over a thread pool, and every output pixel is a weighted
+// average of the tiles covering it. Buffers persist, so streams of images of
+// the same size run without reallocating.
+class TiledReconstructor {
+public:
+  explicit TiledReconstructor(const MLP &model, TileOptions options = {});
+  ~TiledReconstructor();
+  TiledReconstructor(const TiledReconstructor &) = delete;
+  TiledReconstructor &operator=(const TiledReconstructor &) = delete;
+
+  int patch_size() const { return patch; }
+  // image and output are width x height grayscale, row-major
+  TileStats reconstruct(std::span<const float> image, int width, int height,
+                        std::span<float> output);
+
+private:
+  const MLP &model;
+  TileOptions options;
+  int patch = 0;
+  std::unique_ptr<ThreadPool> pool;
+  std::vector<Workspace> workspaces;             // One per worker
+  std::vector<AlignedVector<float>> batch_inputs; // One patch batch per worker
+  AlignedVector<float> tile_outputs;              // Network output for every tile
+  std::vector<float> ramp;                        // Blend weight across one patch
+  std::vector<int> first_tile_x;                  // First tile column covering each x
+};
@@ -0,0 +1,35 @@
+// Workspace.cpp
+#include "Workspace.hpp"
+
+Workspace::Workspace(const std::vector<int>& topology, std::size_t rows) {
+    reserve(topology, rows);
+}
+
+bool Workspace::reserve(const std::vector<int>& topology, std::size_t rows) {
+    if (topology == sizes && rows <= row_capacity) {
+        return false;
+    }
+
+    sizes = topology;
+    row_capacity = rows;
+    strides.clear();
+    activation_offsets.clear();
+    delta_offsets.clear();
+
+    // Every matrix starts on a cache line because every stride is a whole number of lines
+    std::size_t total = 0;
+    for (int size : topology) {
+        strides.push_back(aligned_floats(size));
+        activation_offsets.push_back(total);
+        total += rows * strides.back();
+    }
+    for (std::size_t i = 1; i < topology.size(); ++i) {
+        delta_offsets.push_back(total);
+        total += rows * strides[i];
+    }
+    target_offset = total;
+    total += rows * strides.back();
+
+    arena.assign(total, 0.0f);
+    return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Layer.hpp"
+
+// Scratch arena for up to rows() samples of one topology: per-layer
+// activation matrices, per-weight-layer delta matrices and the label matrix,
+// all row-major with cache-line padded rows and carved from one allocation.
+// Size it once and reuse it; training and inference then never allocate.
+class Workspace {
+public:
+  Workspace() = default;
+  Workspace(const std::vector<int> &topology, std::size_t rows);
+
+  // Grows the arena when the topology or row count does not fit; returns
+  // whether it had to allocate
+  bool reserve(const std::vector<int> &topology, std::size_t rows);
+
+  std::size_t rows() const { return row_capacity; }
+  std::size_t stride(std::size_t layer) const { return strides[layer]; }
+
+  // layer 0 is the input matrix
+  float *activations(std::size_t layer) { return arena.data() + activation_offsets[layer]; }
+  const float *activations(std::size_t layer) const { return arena.data() + activation_offsets[layer]; }
+  // Deltas of weight layer i use the stride of activation layer i + 1
+  float *deltas(std::size_t layer) { return arena.data() + delta_offsets[layer]; }
+  const float *deltas(std::size_t layer) const { return arena.data() + delta_offsets[layer]; }
+  float *targets() { return arena.data() + target_offset; }
+  const float *targets() const { return arena.data() + target_offset; }
+
+private:
+  std::vector<int> sizes;
+  std::vector<std::size_t> strides;
+  std::vector<std::size_t> activation_offsets;
+  std::vector<std::size_t> delta_offsets;
+  std::size_t target_offset = 0;
+  std::size_t row_capacity = 0;
+  AlignedVector<float> arena;
+};
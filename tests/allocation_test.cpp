@@ -0,0 +1,122 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "MLP.hpp"
+#include "Workspace.hpp"
+
+// Replaces global operator new with a counting version and checks that,
+// after one warm-up epoch, further epochs of synchronous and Hogwild training
+// at 1 and several threads allocate nothing, and that repeated predict calls
+// into caller-owned spans allocate nothing either.
+
+namespace {
+
+std::atomic<std::uint64_t> allocations{0};
+
+void* counted_allocation(std::size_t bytes, std::size_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    bytes = bytes == 0 ? 1 : bytes;
+    void* memory = alignment > alignof(std::max_align_t)
+                       ? std::aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment)
+                       : std::malloc(bytes);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+std::uint64_t allocation_count() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+int failures = 0;
+
+void expect_no_allocations(const std::string& name, std::uint64_t count) {
+    std::cout << (count == 0 ? "ok    " : "FAIL  ") << name << ": " << count << " allocations" << std::endl;
+    if (count != 0) {
+        ++failures;
+    }
+}
+
+std::vector<std::vector<float>> random_samples(int count, int size) {
+    std::vector<std::vector<float>> samples(count, std::vector<float>(size));
+    for (auto& sample : samples) {
+        for (float& value : sample) {
+            value = static_cast<float>(rand()) / RAND_MAX;
+        }
+    }
+    return samples;
+}
+
+} // namespace
+
+void* operator new(std::size_t bytes) { return counted_allocation(bytes, 0); }
+void* operator new[](std::size_t bytes) { return counted_allocation(bytes, 0); }
+void* operator new(std::size_t bytes, std::align_val_t alignment) {
+    return counted_allocation(bytes, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t bytes, std::align_val_t alignment) {
+    return counted_allocation(bytes, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+
+int main() {
+    const int size = 64;
+    const std::vector<int> layers = {size, 32, 16, 32, size};
+    const auto samples = random_samples(96, size);
+    const int epochs = 4;
+
+    for (Parallelism parallelism : {Parallelism::Synchronous, Parallelism::Hogwild}) {
+        for (Optimizer optimizer : {Optimizer::SGD, Optimizer::Adam}) {
+            for (int threads : {1, 3}) {
+                MLP mlp(layers, 0.01f);
+                TrainOptions options;
+                options.batch_size = 8;
+                options.threads = threads;
+                options.parallelism = parallelism;
+                options.optimizer.kind = optimizer;
+                options.report_epochs = 0;
+
+                // Everything after the first epoch's report must run without allocating
+                std::uint64_t after_warm_up = 0;
+                std::uint64_t at_end = 0;
+                mlp.set_stats_callback([&](const EpochStats& epoch) {
+                    (epoch.epoch == 1 ? after_warm_up : at_end) = allocation_count();
+                });
+                mlp.train(samples, samples, epochs, options);
+
+                const std::string name = std::string(parallelism == Parallelism::Hogwild ? "hogwild" : "synchronous") +
+                                         " " + optimizer_name(optimizer) + " training, " + std::to_string(threads) +
+                                         " threads, epochs 2-" + std::to_string(epochs);
+                expect_no_allocations(name, at_end - after_warm_up);
+            }
+        }
+    }
+
+    MLP mlp(layers, 0.01f);
+    std::vector<float> output(size);
+    Workspace workspace(layers, 1);
+    mlp.predict(samples[0], output); // Warms up the model's own workspace
+    const std::uint64_t before = allocation_count();
+    for (int i = 0; i < 200; ++i) {
+        const std::vector<float>& input = samples[i % samples.size()];
+        mlp.predict(std::span<const float>(input), std::span<float>(output));
+        mlp.predict(std::span<const float>(input), std::span<float>(output), workspace);
+    }
+    expect_no_allocations("200 predict calls into caller-owned spans", allocation_count() - before);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,343 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Gemm.hpp"
+#include "Kernels.hpp"
+
+// Runs every dispatched kernel on the ISA this CPU picks and again with the
+// scalar path forced, on lengths with every tail from 1 to 15 and starts off
+// the 64-byte grid, and compares the results. Errors are absolute, or
+// relative once the scalar result exceeds 1 in magnitude.
+
+namespace {
+
+// Float sums in a different order: a few ulps of the accumulated magnitude
+constexpr double kSumTolerance = 2e-5;
+// The vector sigmoid's polynomial exp is within 1e-6 relative of std::exp
+constexpr double kSigmoidTolerance = 2e-6;
+// Elementwise updates round the same terms differently
+constexpr double kUpdateTolerance = 1e-6;
+
+std::mt19937 rng(7);
+
+int failures = 0;
+int checks = 0;
+
+std::vector<float> uniform(std::size_t n, float low, float high) {
+    std::uniform_real_distribution<float> distribution(low, high);
+    std::vector<float> values(n);
+    for (float& value : values) {
+        value = distribution(rng);
+    }
+    return values;
+}
+
+// Lengths covering every vector tail, a few full widths and long runs
+std::vector<std::size_t> lengths() {
+    std::vector<std::size_t> result;
+    for (std::size_t n = 1; n <= 40; ++n) {
+        result.push_back(n);
+    }
+    for (std::size_t n : {63, 64, 65, 127, 128, 129, 255, 257, 1000}) {
+        result.push_back(n);
+    }
+    return result;
+}
+
+// Calls run once on the dispatched ISA and once on the scalar path
+std::pair<std::vector<double>, std::vector<double>> both(const std::function<std::vector<double>()>& run) {
+    kernels::force_scalar(false);
+    std::vector<double> fast = run();
+    kernels::force_scalar(true);
+    std::vector<double> scalar = run();
+    kernels::force_scalar(false);
+    return {fast, scalar};
+}
+
+// Records the worst error of one kernel over all its cases
+struct Check {
+    Check(std::string name, double tolerance) : name(std::move(name)), tolerance(tolerance) {}
+
+    std::string name;
+    double tolerance;
+    double worst = 0.0;
+    std::string worst_case;
+
+    void compare(const std::pair<std::vector<double>, std::vector<double>>& results, const std::string& what) {
+        const auto& [fast, scalar] = results;
+        for (std::size_t i = 0; i < scalar.size(); ++i) {
+            const double error = std::fabs(fast[i] - scalar[i]) / std::max(1.0, std::fabs(scalar[i]));
+            if (std::isnan(error) || error > worst) {
+                worst = std::isnan(error) ? INFINITY : error;
+                worst_case = what + " [" + std::to_string(i) + "]";
+            }
+        }
+    }
+
+    ~Check() {
+        ++checks;
+        const bool ok = worst <= tolerance;
+        std::cout << (ok ? "ok    " : "FAIL  ") << name << ": worst error " << worst << " (tolerance " << tolerance << ")";
+        if (!ok) {
+            std::cout << " at " << worst_case;
+            ++failures;
+        }
+        std::cout << std::endl;
+    }
+};
+
+std::string describe(std::size_t n, std::size_t offset) {
+    return "n=" + std::to_string(n) + " offset=" + std::to_string(offset);
+}
+
+void test_dot() {
+    Check check{"dot", kSumTolerance};
+    for (std::size_t n : lengths()) {
+        for (std::size_t offset : {0, 1, 3}) {
+            const std::vector<float> a = uniform(n + offset, -1.0f, 1.0f);
+            const std::vector<float> b = uniform(n + offset, -1.0f, 1.0f);
+            check.compare(both([&] { return std::vector<double>{kernels::dot(a.data() + offset, b.data() + offset, n)}; }),
+                          describe(n, offset));
+        }
+    }
+}
+
+void test_dot_rows() {
+    Check check{"dot_rows", kSumTolerance};
+    for (std::size_t n : lengths()) {
+        for (std::size_t rows : {1, 2, 3, 4, 5, 7, 8, 9}) {
+            const std::size_t offset = rows % 3;
+            const std::size_t lda = n + rows % 5; // Rows start on and off the grid
+            const std::vector<float> a = uniform(rows * lda + offset, -1.0f, 1.0f);
+            const std::vector<float> x = uniform(n + offset, -1.0f, 1.0f);
+            check.compare(both([&] {
+                              std::vector<float> out(rows);
+                              kernels::dot_rows(a.data() + offset, lda, x.data() + offset, n, rows, out.data());
+                              return std::vector<double>(out.begin(), out.end());
+                          }),
+                          describe(n, offset) + " rows=" + std::to_string(rows));
+        }
+    }
+}
+
+void test_axpy() {
+    Check check{"axpy", kUpdateTolerance};
+    for (std::size_t n : lengths()) {
+        for (std::size_t offset : {0, 1, 5}) {
+            const std::vector<float> x = uniform(n + offset, -1.0f, 1.0f);
+            const std::vector<float> y = uniform(n + offset, -1.0f, 1.0f);
+            check.compare(both([&] {
+                              std::vector<float> out = y;
+                              kernels::axpy(-0.37f, x.data() + offset, out.data() + offset, n);
+                              return std::vector<double>(out.begin(), out.end());
+                          }),
+                          describe(n, offset));
+        }
+    }
+}
+
+void test_bias_sigmoid() {
+    Check check{"bias_sigmoid", kSigmoidTolerance};
+    for (std::size_t n : lengths()) {
+        for (std::size_t offset : {0, 2, 7}) {
+            const std::vector<float> x = uniform(n + offset, -12.0f, 12.0f);
+            const std::vector<float> bias = uniform(n + offset, -1.0f, 1.0f);
+            check.compare(both([&] {
+                              std::vector<float> out = x;
+                              kernels::bias_sigmoid(out.data() + offset, bias.data() + offset, n);
+                              return std::vector<double>(out.begin(), out.end());
+                          }),
+                          describe(n, offset));
+        }
+    }
+}
+
+void test_momentum_update() {
+    Check check{"momentum_update", kUpdateTolerance};
+    kernels::UpdateStep step;
+    step.grad_scale = 1.0f / 8;
+    step.rate = 0.01f;
+    for (std::size_t n : lengths()) {
+        for (std::size_t offset : {0, 1, 3}) {
+            const std::vector<float> w = uniform(n + offset, -1.0f, 1.0f);
+            const std::vector<float> g = uniform(n + offset, -8.0f, 8.0f);
+            const std::vector<float> v = uniform(n + offset, -1.0f, 1.0f);
+            check.compare(both([&] {
+                              std::vector<float> weights = w;
+                              std::vector<float> velocity = v;
+                              kernels::momentum_update(weights.data() + offset, g.data() + offset, velocity.data() + offset, n, step);
+                              std::vector<double> out(weights.begin(), weights.end());
+                              out.insert(out.end(), velocity.begin(), velocity.end());
+                              return out;
+                          }),
+                          describe(n, offset));
+        }
+    }
+}
+
+void test_adam_update() {
+    Check check{"adam_update", kUpdateTolerance};
+    kernels::UpdateStep step;
+    step.grad_scale = 1.0f / 8;
+    step.rate = 0.001f;
+    for (std::size_t n : lengths()) {
+        for (std::size_t offset : {0, 1, 3}) {
+            const std::vector<float> w = uniform(n + offset, -1.0f, 1.0f);
+            const std::vector<float> g = uniform(n + offset, -8.0f, 8.0f);
+            const std::vector<float> m = uniform(n + offset, -0.1f, 0.1f);
+            const std::vector<float> v = uniform(n + offset, 0.0f, 0.01f);
+            check.compare(both([&] {
+                              std::vector<float> weights = w;
+                              std::vector<float> first = m;
+                              std::vector<float> second = v;
+                              kernels::adam_update(weights.data() + offset, g.data() + offset, first.data() + offset,
+                                                   second.data() + offset, n, step);
+                              std::vector<double> out(weights.begin(), weights.end());
+                              out.insert(out.end(), first.begin(), first.end());
+                              out.insert(out.end(), second.begin(), second.end());
+                              return out;
+                          }),
+                          describe(n, offset));
+        }
+    }
+}
+
+void test_dot_u8s8() {
+    Check check{"dot_u8s8", 0.0}; // Integer accumulation must match exactly
+    std::uniform_int_distribution<int> activation(0, 127);
+    std::uniform_int_distribution<int> weight(-128, 127);
+    for (std::size_t n : {64, 128, 192, 256, 1024}) { // Multiples of 64, as the kernel requires
+        for (std::size_t offset : {0, 1, 13}) {
+            std::vector<std::uint8_t> a(n + offset);
+            std::vector<std::int8_t> b(n + offset);
+            for (std::size_t i = 0; i < n + offset; ++i) {
+                a[i] = static_cast<std::uint8_t>(activation(rng));
+                b[i] = static_cast<std::int8_t>(weight(rng));
+            }
+            check.compare(both([&] { return std::vector<double>{static_cast<double>(kernels::dot_u8s8(a.data() + offset, b.data() + offset, n))}; }),
+                          describe(n, offset));
+        }
+    }
+}
+
+void test_dot_16bit() {
+    Check bf16{"dot_bf16", kSumTolerance};
+    Check f16{"dot_f16", kSumTolerance};
+    for (std::size_t n : lengths()) {
+        for (std::size_t offset : {0, 1, 3}) {
+            const std::vector<float> a = uniform(n + offset, -1.0f, 1.0f);
+            const std::vector<float> weights = uniform(n + offset, -1.0f, 1.0f);
+            std::vector<std::uint16_t> b_bf16(n + offset);
+            std::vector<std::uint16_t> b_f16(n + offset);
+            for (std::size_t i = 0; i < n + offset; ++i) {
+                b_bf16[i] = kernels::float_to_bf16(weights[i]);
+                b_f16[i] = kernels::float_to_f16(weights[i]);
+            }
+            bf16.compare(both([&] { return std::vector<double>{kernels::dot_bf16(a.data() + offset, b_bf16.data() + offset, n)}; }),
+                         describe(n, offset));
+            f16.compare(both([&] { return std::vector<double>{kernels::dot_f16(a.data() + offset, b_f16.data() + offset, n)}; }),
+                        describe(n, offset));
+        }
+    }
+}
+
+void test_gemm() {
+    Check check{"gemm", kSumTolerance};
+    // m of 1 takes the row path, m under 32 streams B, larger m packs for the micro-kernel
+    for (int m : {1, 3, 17, 31, 32, 45, 100}) {
+        for (int n : {1, 7, 16, 33, 130}) {
+            for (int k : {1, 5, 64, 77, 300}) {
+                for (Transpose trans_a : {Transpose::No, Transpose::Yes}) {
+                    for (Transpose trans_b : {Transpose::No, Transpose::Yes}) {
+                        const std::size_t lda = (trans_a == Transpose::No ? k : m) + 3;
+                        const std::size_t ldb = (trans_b == Transpose::No ? n : k) + 1;
+                        const std::size_t ldc = n + 2;
+                        const std::vector<float> a = uniform(lda * (trans_a == Transpose::No ? m : k) + 1, -1.0f, 1.0f);
+                        const std::vector<float> b = uniform(ldb * (trans_b == Transpose::No ? k : n) + 1, -1.0f, 1.0f);
+                        const std::vector<float> c = uniform(ldc * m + 1, -1.0f, 1.0f);
+                        check.compare(both([&] {
+                                          std::vector<float> out = c;
+                                          gemm(trans_a, trans_b, m, n, k, 0.5f, a.data() + 1, lda, b.data() + 1, ldb, 0.25f,
+                                               out.data() + 1, ldc);
+                                          return std::vector<double>(out.begin(), out.end());
+                                      }),
+                                      "m=" + std::to_string(m) + " n=" + std::to_string(n) + " k=" + std::to_string(k) +
+                                          " trans=" + std::to_string(trans_a == Transpose::Yes) + std::to_string(trans_b == Transpose::Yes));
+                    }
+                }
+            }
+        }
+    }
+}
+
+void test_block_sparse_multiply() {
+    Check check{"block_sparse_multiply", kSumTolerance};
+    std::bernoulli_distribution keep(0.3);
+    const std::pair<int, int> shapes[] = {{1, 1}, {1, 8}, {1, 16}, {2, 8}, {2, 16}, {4, 8}, {4, 16}, {8, 8}, {8, 16}};
+    for (auto [block_rows, block_cols] : shapes) {
+        for (int rows : {1, 13, 40}) {
+            for (int cols : {5, 50, 129}) {
+                // Every sample row is readable past the last column, as the padded layout guarantees
+                const std::size_t ldx = static_cast<std::size_t>(cols) + 16 + 3;
+                std::vector<float> values;
+                std::vector<std::int32_t> columns;
+                std::vector<std::int32_t> offsets = {0};
+                for (int r0 = 0; r0 < rows; r0 += block_rows) {
+                    for (int c = 0; c < cols; c += block_cols) {
+                        if (keep(rng)) {
+                            columns.push_back(c);
+                            const std::vector<float> block = uniform(static_cast<std::size_t>(block_rows) * block_cols, -1.0f, 1.0f);
+                            values.insert(values.end(), block.begin(), block.end());
+                        }
+                    }
+                    offsets.push_back(static_cast<std::int32_t>(columns.size()));
+                }
+                kernels::BlockSparseMatrix matrix;
+                matrix.rows = rows;
+                matrix.cols = cols;
+                matrix.block_rows = block_rows;
+                matrix.block_cols = block_cols;
+                matrix.values = values.data();
+                matrix.columns = columns.data();
+                matrix.row_offsets = offsets.data();
+
+                for (std::size_t count : {1, 2, 5}) {
+                    const std::vector<float> x = uniform(count * ldx + 1, 0.0f, 1.0f);
+                    const std::size_t ldy = static_cast<std::size_t>(rows) + 1;
+                    check.compare(both([&] {
+                                      std::vector<float> y(count * ldy + 1, 0.0f);
+                                      kernels::block_sparse_multiply(matrix, x.data() + 1, ldx, y.data() + 1, ldy, count);
+                                      return std::vector<double>(y.begin(), y.end());
+                                  }),
+                                  std::to_string(block_rows) + "x" + std::to_string(block_cols) + " rows=" + std::to_string(rows) +
+                                      " cols=" + std::to_string(cols) + " count=" + std::to_string(count));
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Comparing " << kernels::isa_name(kernels::active_isa()) << " against scalar" << std::endl;
+    test_dot();
+    test_dot_rows();
+    test_axpy();
+    test_bias_sigmoid();
+    test_momentum_update();
+    test_adam_update();
+    test_dot_u8s8();
+    test_dot_16bit();
+    test_gemm();
+    test_block_sparse_multiply();
+    std::cout << checks - failures << "/" << checks << " kernels match" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
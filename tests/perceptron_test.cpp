@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Kernels.hpp"
+#include "Perceptron.hpp"
+
+// Checks the perceptron against naive references: plain and averaged training
+// against a loop that keeps every step's weights and takes their mean, batched
+// scoring against a scalar dot product, and an empty training set as a no-op.
+
+namespace {
+
+// Float sums in a different order than the double reference
+constexpr double kTolerance = 1e-4;
+
+std::mt19937 rng(11);
+
+int failures = 0;
+
+void expect(bool passed, const std::string& name, const std::string& detail = "") {
+    std::cout << (passed ? "ok    " : "FAIL  ") << name << (detail.empty() ? "" : ": " + detail) << std::endl;
+    if (!passed) {
+        ++failures;
+    }
+}
+
+// Samples around a random hyperplane, with a tenth of the labels flipped so
+// training keeps making mistakes in later epochs
+void make_samples(int count, int features, std::vector<std::vector<float>>& samples, std::vector<int>& labels) {
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    std::vector<float> plane(features);
+    for (float& w : plane) {
+        w = value(rng);
+    }
+    samples.assign(count, std::vector<float>(features));
+    labels.assign(count, 0);
+    for (int i = 0; i < count; ++i) {
+        double score = 0.1;
+        for (int j = 0; j < features; ++j) {
+            samples[i][j] = value(rng);
+            score += samples[i][j] * plane[j];
+        }
+        labels[i] = (score >= 0.0) != (rng() % 10 == 0);
+    }
+}
+
+// Largest absolute difference between the perceptron and the reference
+double difference(const Perceptron& perceptron, const std::vector<double>& weights, double bias) {
+    double worst = std::fabs(perceptron.bias_value() - bias);
+    const auto values = perceptron.weight_values();
+    for (std::size_t j = 0; j < weights.size(); ++j) {
+        worst = std::max(worst, std::fabs(values[j] - weights[j]));
+    }
+    return worst;
+}
+
+void check_training(bool averaged) {
+    const int features = 23;
+    const int epochs = 5;
+    const float learning_rate = 0.1f;
+    std::vector<std::vector<float>> samples;
+    std::vector<int> labels;
+    make_samples(200, features, samples, labels);
+
+    Perceptron perceptron(features, learning_rate);
+    const auto initial = perceptron.weight_values();
+    std::vector<float> weights(initial.begin(), initial.end());
+    float bias = perceptron.bias_value();
+
+    // The mean runs over the starting weights and the weights after every step
+    std::vector<double> sum(weights.begin(), weights.end());
+    double bias_sum = bias;
+    long states = 1;
+    for (int epoch = 0; epoch < epochs; ++epoch) {
+        for (std::size_t i = 0; i < samples.size(); ++i) {
+            double score = bias;
+            for (int j = 0; j < features; ++j) {
+                score += static_cast<double>(samples[i][j]) * weights[j];
+            }
+            const float error = static_cast<float>(labels[i]) - (score >= 0.0 ? 1.0f : 0.0f);
+            for (int j = 0; j < features; ++j) {
+                weights[j] += learning_rate * error * samples[i][j];
+                sum[j] += weights[j];
+            }
+            bias += learning_rate * error;
+            bias_sum += bias;
+            ++states;
+        }
+    }
+
+    std::vector<double> expected(features);
+    double expected_bias = 0.0;
+    if (averaged) {
+        for (int j = 0; j < features; ++j) {
+            expected[j] = sum[j] / states;
+        }
+        expected_bias = bias_sum / states;
+    } else {
+        std::copy(weights.begin(), weights.end(), expected.begin());
+        expected_bias = bias;
+    }
+
+    PerceptronOptions options;
+    options.averaged = averaged;
+    perceptron.train(SampleMatrix(samples), labels, epochs, options);
+    const double error = difference(perceptron, expected, expected_bias);
+    expect(error <= kTolerance, std::string(averaged ? "averaged" : "plain") + " training matches the naive loop",
+           "worst difference " + std::to_string(error));
+}
+
+void check_scores() {
+    double worst = 0.0;
+    for (int features : {1, 7, 16, 33, 100}) {
+        std::vector<std::vector<float>> samples;
+        std::vector<int> labels;
+        make_samples(37, features, samples, labels);
+        const SampleMatrix matrix(samples);
+        std::vector<float> weights(matrix.stride(), 0.0f);
+        std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+        for (int j = 0; j < features; ++j) {
+            weights[j] = value(rng);
+        }
+
+        std::vector<float> scores(samples.size());
+        kernels::dot_rows(matrix.row(0), matrix.stride(), weights.data(), matrix.stride(), samples.size(),
+                          scores.data());
+        for (std::size_t i = 0; i < samples.size(); ++i) {
+            double expected = 0.0;
+            for (int j = 0; j < features; ++j) {
+                expected += static_cast<double>(samples[i][j]) * weights[j];
+            }
+            worst = std::max(worst, std::fabs(scores[i] - expected));
+        }
+    }
+    expect(worst <= kTolerance, "dot_rows matches a scalar dot product", "worst difference " + std::to_string(worst));
+}
+
+void check_empty_training() {
+    Perceptron perceptron(5, 0.1f);
+    const auto before = perceptron.weight_values();
+    const std::vector<float> weights(before.begin(), before.end());
+    bool passed = true;
+    try {
+        perceptron.train(std::vector<std::vector<float>>{}, std::vector<int>{}, 3);
+        const auto after = perceptron.weight_values();
+        passed = std::equal(weights.begin(), weights.end(), after.begin()) && perceptron.bias_value() == 0.0f;
+    } catch (const std::exception&) {
+        passed = false;
+    }
+    expect(passed, "training on no samples leaves the perceptron as it was");
+}
+
+} // namespace
+
+int main() {
+    srand(5);
+    check_training(false);
+    check_training(true);
+    check_scores();
+    check_empty_training();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Checkpoint.hpp"
+#include "Dataset.hpp"
+#include "MLP.hpp"
+
+// Trains a model for the full run in one call, and again for part of the run,
+// resumes the checkpoint in a fresh model and trains it to the end. Synchronous
+// training must then end on the same parameters bit for bit, for SGD and Adam
+// at 1 and several threads, with early stopping on a validation set, and for a
+// pruned model, whose pruned weights must also still be zero.
+
+namespace {
+
+constexpr int kEpochs = 6;
+constexpr int kResumeAt = 2;
+
+int failures = 0;
+
+void expect(bool passed, const std::string& name) {
+    std::cout << (passed ? "ok    " : "FAIL  ") << name << std::endl;
+    if (!passed) {
+        ++failures;
+    }
+}
+
+std::vector<std::vector<float>> random_samples(int count, int size) {
+    std::vector<std::vector<float>> samples(count, std::vector<float>(size));
+    for (auto& sample : samples) {
+        for (float& value : sample) {
+            value = static_cast<float>(rand()) / RAND_MAX;
+        }
+    }
+    return samples;
+}
+
+std::string temporary(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / ("mlp_resume_test_" + name)).string();
+}
+
+// The parameter buffer of a model, as save_model writes it
+std::vector<float> parameters(MLP& mlp) {
+    const std::string filename = temporary("parameters.bin");
+    mlp.save_model(filename);
+    const ModelHeader header = read_model_header(filename);
+    std::vector<float> values(header.payload_bytes / sizeof(float));
+    std::ifstream file(filename, std::ios::binary);
+    file.seekg(static_cast<std::streamoff>(header.payload_offset));
+    file.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(header.payload_bytes));
+    std::filesystem::remove(filename);
+    return values;
+}
+
+struct Case {
+    std::string name;
+    Optimizer optimizer;
+    int threads;
+    bool validation;
+    bool pruned;
+};
+
+void check(const Case& test, const std::string& initial, const PruneOptions& prune,
+           const std::vector<std::vector<float>>& samples, const std::vector<std::vector<float>>& held_out) {
+    TrainOptions options;
+    options.batch_size = 8;
+    options.threads = test.threads;
+    options.optimizer.kind = test.optimizer;
+    options.checkpoint_path = temporary("checkpoint.bin");
+    options.checkpoint_epochs = 1;
+    options.report_epochs = 0;
+    options.patience = test.validation ? kEpochs : 0;
+
+    // Both runs read the same samples in order and start from the same
+    // weights, pruned the same way in the pruned case
+    auto start = [&] {
+        MLP mlp = MLP::from_file(initial);
+        if (test.pruned) {
+            mlp.prune(prune);
+        }
+        return mlp;
+    };
+    auto train = [&](MLP& mlp, int first_epoch, int epochs) {
+        MemoryDataset data(samples, samples);
+        MemoryDataset validation(held_out, held_out);
+        TrainOptions run = options;
+        run.first_epoch = first_epoch;
+        run.validation = test.validation ? &validation : nullptr;
+        mlp.train(data, epochs, run);
+    };
+
+    MLP whole = start();
+    train(whole, 0, kEpochs);
+    const std::vector<float> expected = parameters(whole);
+
+    MLP part = start();
+    train(part, 0, kResumeAt);
+    TrainingState state;
+    MLP resumed = MLP::resume(options.checkpoint_path, state);
+    train(resumed, static_cast<int>(state.epoch), kEpochs);
+    const std::vector<float> actual = parameters(resumed);
+    std::filesystem::remove(options.checkpoint_path);
+
+    const bool same = state.epoch == kResumeAt && actual.size() == expected.size() &&
+                      std::memcmp(actual.data(), expected.data(), actual.size() * sizeof(float)) == 0;
+    expect(same, test.name + ": resumed run matches the uninterrupted one");
+
+    if (test.pruned) {
+        MLP untrained = start();
+        const std::vector<float> pruned = parameters(untrained);
+        std::size_t zeros = 0;
+        bool still_zero = true;
+        for (std::size_t i = 0; i < pruned.size(); ++i) {
+            if (pruned[i] == 0.0f) {
+                ++zeros;
+                still_zero = still_zero && actual[i] == 0.0f;
+            }
+        }
+        expect(zeros > 0 && still_zero, test.name + ": pruned weights stay zero after resume");
+    }
+}
+
+} // namespace
+
+int main() {
+    srand(3);
+    const int size = 48;
+    const std::vector<int> layers = {size, 64, 32, 64, size};
+    const auto samples = random_samples(64, size);
+    const auto held_out = random_samples(16, size);
+
+    const std::string initial = temporary("initial.bin");
+    MLP(layers, 0.01f).save_model(initial);
+
+    PruneOptions prune;
+    prune.sparsity = 0.5f;
+    prune.block_rows = 4;
+    prune.block_cols = 8;
+    prune.min_weights = 1024;
+
+    const std::vector<Case> cases = {
+        {"SGD, 1 thread", Optimizer::SGD, 1, false, false},
+        {"SGD, 3 threads", Optimizer::SGD, 3, false, false},
+        {"Adam, 1 thread", Optimizer::Adam, 1, false, false},
+        {"Adam, 3 threads", Optimizer::Adam, 3, false, false},
+        {"Adam with validation, 3 threads", Optimizer::Adam, 3, true, false},
+        {"pruned 4x8 Adam, 3 threads", Optimizer::Adam, 3, false, true},
+    };
+    for (const Case& test : cases) {
+        check(test, initial, prune, samples, held_out);
+    }
+
+    std::filesystem::remove(initial);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+
+// ModelTools.cpp
+#include "ModelTools.hpp"
+#include "Dataset.hpp"
+
+int patch_for(const std::string& image, int input_size) {
+    DatasetOptions options;
+    options.shuffle_buffer = 0;
+    ImageDataset whole(image, options);
+    return whole.input_size() == input_size ? 0 : static_cast<int>(std::lround(std::sqrt(static_cast<double>(input_size))));
+}
+
+std::vector<float> load_samples(const std::string& image, int input_size, int& count) {
+    std::vector<float> samples;
+    if (std::filesystem::exists(image)) {
+        DatasetOptions options;
+        options.shuffle_buffer = 0;
+        options.patch = patch_for(image, input_size);
+        ImageDataset dataset(image, options);
+        if (dataset.input_size() == input_size) {
+            Batch batch;
+            dataset.start_epoch(0, kBatch);
+            while (dataset.next(batch) && samples.size() < static_cast<size_t>(kMaxSamples) * input_size) {
+                for (const float* row : batch.inputs) {
+                    samples.insert(samples.end(), row, row + input_size);
+                }
+            }
+        }
+    }
+    if (samples.empty()) {
+        std::cout << "No image matching the model input; using random samples" << std::endl;
+        samples.resize(static_cast<size_t>(kBatch) * input_size);
+        for (float& value : samples) {
+            value = static_cast<float>(rand()) / RAND_MAX;
+        }
+    }
+    count = std::min(kMaxSamples, static_cast<int>(samples.size() / input_size));
+    samples.resize(static_cast<size_t>(count) * input_size);
+    return samples;
+}
+
+double psnr(const std::vector<float>& reference, const std::vector<float>& output) {
+    double error = 0.0;
+    for (size_t i = 0; i < reference.size(); ++i) {
+        error += (reference[i] - output[i]) * (reference[i] - output[i]);
+    }
+    error /= reference.size();
+    return error == 0.0 ? INFINITY : 10.0 * std::log10(1.0 / error); // Pixels span [0, 1]
+}
+
+void print_report_header(const std::string& model_column, const std::string& reference) {
+    std::cout << std::left << std::setw(8) << model_column << "weights (KB)  batch 1 (us)  batch " << kBatch
+              << " (us/sample)  PSNR vs " << reference << " (dB)" << std::endl;
+}
+
+void print_report_row(const std::string& name, std::size_t bytes, double single_seconds, double batched_seconds,
+                      double quality) {
+    std::cout << std::left << std::setw(8) << name << std::setw(14) << bytes / 1024 << std::setw(14) << std::fixed
+              << std::setprecision(2) << single_seconds * 1e6 << std::setw(23) << batched_seconds * 1e6
+              << std::setprecision(1) << quality << std::endl;
+}
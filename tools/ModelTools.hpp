@@ -0,0 +1,43 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Shared by the model conversion tools and benchmarks: sample loading,
+// timing and the size, latency and quality report they print.
+
+constexpr int kBatch = 64;       // Rows per batched predict call
+constexpr int kMaxSamples = 256; // Samples read from the image
+
+// Patch size for models smaller than the image, as TrainModel --patch cut it; 0 for whole-image models
+int patch_for(const std::string &image, int input_size);
+
+// Up to kMaxSamples samples from the image, whole or cut into patches to match
+// input_size, else kBatch samples of uniform noise. count is set to the number of samples.
+std::vector<float> load_samples(const std::string &image, int input_size, int &count);
+
+// Best of runs passes of predict(first, count) over every sample in batches, in seconds per sample
+template <typename Predict>
+double time_per_sample(int samples, int batch, Predict predict, int runs = 3) {
+  double best = 1e30;
+  for (int run = 0; run < runs; ++run) {
+    auto start = std::chrono::steady_clock::now();
+    for (int first = 0; first < samples; first += batch) {
+      predict(first, std::min(batch, samples - first));
+    }
+    best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+  return best / samples;
+}
+
+// Peak signal-to-noise ratio of output against reference, for pixels in [0, 1]
+double psnr(const std::vector<float> &reference, const std::vector<float> &output);
+
+// Report table: one row per model with its weight size, latency at batch 1
+// and at kBatch, and PSNR against the reference named in the header
+void print_report_header(const std::string &model_column, const std::string &reference);
+void print_report_row(const std::string &name, std::size_t bytes, double single_seconds, double batched_seconds,
+                      double quality);
@@ -1,62 +1,147 @@
+#include <filesystem>
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <string>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
+#include "Dataset.hpp"
 #include "MLP.hpp"
 
-// Function to load image from a file using STB Image
-std::vector<float> load_image(const std::string& filename, int& width, int& height) {
-    int channels;
-    unsigned char* data = stbi_load(filename.c_str(), &width, &height, &channels, 1); // Load image as grayscale
-
-    if (data == nullptr) {
-        std::cerr << "Error: Could not load image " << filename << std::endl;
-        exit(1);
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <epochs> [batch_size] [--threads N] [--hogwild] [--patch N]"
+                  << " [--data PATH] [--decoders N] [--shuffle N] [--seed N]"
+                  << " [--checkpoint PATH] [--checkpoint-every N] [--checkpoint-seconds S] [--resume]"
+                  << " [--optimizer sgd|momentum|adam] [--lr R] [--momentum M]"
+                  << " [--schedule constant|step|cosine] [--warmup N] [--step-epochs N] [--step-factor F]"
+                  << " [--validation PATH] [--patience N] [--min-delta D] [--target-loss L] [--report-every N]"
+                  << std::endl;
+        return 1;
     }
 
-    std::vector<float> image(width * height); // Create a flat vector for grayscale image
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            image[y * width + x] = data[y * width + x] / 255.0f; // Normalize pixel values to [0, 1]
+    // Parse the number of epochs, the optional mini-batch size, the threading and the dataset flags
+    int epochs = std::stoi(argv[1]);
+    TrainOptions options;
+    DatasetOptions dataset_options;
+    std::string data_path = "image.bmp"; // An image, a directory of images or a packed shard
+    std::string checkpoint_path = "mlp_checkpoint.dat";
+    std::string validation_path; // Held-out images for early stopping
+    bool resume = false;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            options.threads = std::stoi(argv[++i]); // 0 uses every hardware thread
+        } else if (arg == "--patch" && i + 1 < argc) {
+            dataset_options.patch = std::stoi(argv[++i]); // Train on overlapping patch x patch tiles
+        } else if (arg == "--data" && i + 1 < argc) {
+            data_path = argv[++i];
+        } else if (arg == "--decoders" && i + 1 < argc) {
+            dataset_options.decode_threads = std::stoi(argv[++i]);
+        } else if (arg == "--shuffle" && i + 1 < argc) {
+            dataset_options.shuffle_buffer = std::stoul(argv[++i]); // 0 keeps file order
+        } else if (arg == "--seed" && i + 1 < argc) {
+            dataset_options.seed = std::stoull(argv[++i]);
+        } else if (arg == "--checkpoint" && i + 1 < argc) {
+            checkpoint_path = argv[++i];
+        } else if (arg == "--checkpoint-every" && i + 1 < argc) {
+            options.checkpoint_epochs = std::stoi(argv[++i]);
+        } else if (arg == "--checkpoint-seconds" && i + 1 < argc) {
+            options.checkpoint_seconds = std::stod(argv[++i]);
+        } else if (arg == "--resume") {
+            resume = true; // Continue from the checkpoint; the other flags must match the original run
+        } else if (arg == "--hogwild") {
+            options.parallelism = Parallelism::Hogwild;
+        } else if (arg == "--optimizer" && i + 1 < argc) {
+            const std::string name = argv[++i];
+            if (name == "sgd") {
+                options.optimizer.kind = Optimizer::SGD;
+            } else if (name == "momentum") {
+                options.optimizer.kind = Optimizer::Momentum;
+            } else if (name == "adam") {
+                options.optimizer.kind = Optimizer::Adam;
+            } else {
+                std::cerr << "Unknown optimizer: " << name << std::endl;
+                return 1;
+            }
+        } else if (arg == "--lr" && i + 1 < argc) {
+            options.learning_rate = std::stof(argv[++i]); // Adam wants about 1e-3
+        } else if (arg == "--momentum" && i + 1 < argc) {
+            options.optimizer.momentum = std::stof(argv[++i]);
+        } else if (arg == "--schedule" && i + 1 < argc) {
+            const std::string name = argv[++i];
+            if (name == "constant") {
+                options.schedule.kind = Schedule::Constant;
+            } else if (name == "step") {
+                options.schedule.kind = Schedule::Step;
+            } else if (name == "cosine") {
+                options.schedule.kind = Schedule::Cosine;
+            } else {
+                std::cerr << "Unknown schedule: " << name << std::endl;
+                return 1;
+            }
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            options.schedule.warmup_epochs = std::stoi(argv[++i]);
+        } else if (arg == "--step-epochs" && i + 1 < argc) {
+            options.schedule.step_epochs = std::stoi(argv[++i]);
+        } else if (arg == "--step-factor" && i + 1 < argc) {
+            options.schedule.step_factor = std::stof(argv[++i]);
+        } else if (arg == "--validation" && i + 1 < argc) {
+            validation_path = argv[++i];
+        } else if (arg == "--patience" && i + 1 < argc) {
+            options.patience = std::stoi(argv[++i]);
+        } else if (arg == "--min-delta" && i + 1 < argc) {
+            options.min_delta = std::stof(argv[++i]);
+        } else if (arg == "--target-loss" && i + 1 < argc) {
+            options.target_loss = std::stof(argv[++i]); // Mean squared error per pixel
+        } else if (arg == "--report-every" && i + 1 < argc) {
+            options.report_epochs = std::stoi(argv[++i]);
+        } else if (i == 2) {
+            options.batch_size = std::stoi(arg);
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
         }
     }
 
-    stbi_image_free(data);
-    return image; // Return the flat vector
-}
+    if (options.checkpoint_epochs > 0 || options.checkpoint_seconds > 0.0 || resume) {
+        options.checkpoint_path = checkpoint_path;
+    }
 
-int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <epochs>" << std::endl;
-        return 1;
+    // Pick up the epoch and shuffle seed where the checkpointed run stopped
+    TrainingState state;
+    if (resume) {
+        if (!std::filesystem::exists(checkpoint_path)) {
+            std::cerr << "No checkpoint at " << checkpoint_path << std::endl;
+            return 1;
+        }
+        state = read_checkpoint_state(checkpoint_path);
+        dataset_options.seed = state.data_seed;
+        options.first_epoch = static_cast<int>(state.epoch);
+        std::cout << "Resuming after epoch " << state.epoch << " of " << epochs << std::endl;
     }
 
-    // Parse the number of epochs from the command-line argument
-    int epochs = std::stoi(argv[1]);
+    // Stream the images; decoding runs in the background while the network trains
+    ImageDataset dataset(data_path, dataset_options);
+    int sample_size = dataset.input_size();
 
-    // Load and preprocess image
-    std::string image_filename = "image.bmp";
-    int width, height;
-    std::vector<float> inputs = load_image(image_filename, width, height);
+    // Scored in file order after every epoch for early stopping
+    std::unique_ptr<ImageDataset> validation;
+    if (!validation_path.empty()) {
+        DatasetOptions validation_options = dataset_options;
+        validation_options.shuffle_buffer = 0;
+        validation = std::make_unique<ImageDataset>(validation_path, validation_options);
+        options.validation = validation.get();
+    }
 
-    // Define the MLP architecture based on image size
-    std::vector<int> layers = {width * height, 128, 64, 32, 64, 128, width * height}; // Example architecture
+    // Define the MLP architecture based on the sample size
+    std::vector<int> layers = {sample_size, 128, 64, 32, 64, 128, sample_size}; // Example architecture
     float learning_rate = 0.01;
 
-    // Create MLP instance
-    MLP mlp(layers, learning_rate);
-
-    // Define labels (for simplicity, let's assume labels are the same as inputs for reconstruction)
-    std::vector<float> labels = inputs; // Ensure labels are also flat
-
-    // Create vectors of vectors for inputs and labels
-    std::vector<std::vector<float>> input_batch = {inputs}; // Wrap input in a vector of vectors
-    std::vector<std::vector<float>> label_batch = {labels}; // Wrap label in a vector of vectors
+    // Create MLP instance, or restore the checkpointed weights
+    MLP mlp = resume ? MLP::resume(checkpoint_path, state) : MLP(layers, learning_rate);
 
-    // Train the MLP
-    mlp.train(input_batch, label_batch, epochs); // Use the wrapped vectors
+    // Train the MLP to reconstruct its inputs
+    mlp.train(dataset, epochs, options);
 
     // Save the trained model
     std::string model_filename = "mlp_model.dat";